@@ -53,7 +53,19 @@ namespace gk{
         
         BaseDataBox(const long startFrame);
         
+        /**
+         * Cheap part of frame: advances input and updates ROI, depth and
+         * metric center, which is all camera selection needs.
+         * 
+         * @return False at end of input.
+         */
         virtual bool update() = 0;
+        
+        /**
+         * Expensive part of frame: calculates angle and magnitude between
+         * frames of last two update() calls. Only selected camera needs it.
+         */
+        virtual void calculateFlow() = 0;
 
         
     };
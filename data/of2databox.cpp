@@ -29,10 +29,16 @@ OF2DataBox::OF2DataBox(const string& videoFilename,
         const string& diagFilename,
         const long startFrame,
         const OpticalFlowData& opticalFlowData,
-        const TrackerData& trackerData)
+        const TrackerData& trackerData,
+        const std::shared_ptr<SelectionPlan>& selectionPlan,
+        const int camera)
 : BaseDataBox(startFrame), videoFilename(videoFilename),
 opticalFlowData(opticalFlowData),
-trackerData(trackerData) {
+trackerData(trackerData),
+pyramidBuilt(false),
+prevPyramidBuilt(false),
+selectionPlan(selectionPlan),
+camera(camera) {
 
     configInput(videoFilename, depthFilename, startFrame);
     configTracker(trackerFilename, startFrame);
@@ -45,7 +51,13 @@ void OF2DataBox::configInput(const string& videoFilename,
         const string& depthFilename,
         const long startFrame) {
 
-    video = make_shared<VideoCapture>(videoFilename);
+    vector<bool> neededFrames;
+    if (selectionPlan) {
+        neededFrames = selectionPlan->getNeededFrames(camera, this->startFrame);
+    }
+    // Video starts with same frame as tracker, time and depth files
+    video = make_shared<FrameDecoder>(videoFilename, opticalFlowData.decodeDepth, 
+            neededFrames, this->startFrame - 1, opticalFlowData.lumaDecode);
     if (!video->isOpened()) {
 
         string message = "Could not open the input video: " + videoFilename;
@@ -64,7 +76,10 @@ void OF2DataBox::configInput(const string& videoFilename,
 
 
 
-    depthInputSequence = std::make_shared<InputSequence>(depthFilename, startFrame);
+    if (!selectionPlan) {
+        depthSequence = std::make_shared<DepthSequence>(depthFilename, startFrame,
+                opticalFlowData.prefetchDepth, opticalFlowData.prefetchThreads);
+    }
 
     timer = std::make_shared<VideoTimer>(video, 1.0, 0);
     timer->start();
@@ -72,7 +87,9 @@ void OF2DataBox::configInput(const string& videoFilename,
 
 void OF2DataBox::configTracker(const string& trackerFilename, const long startFrame) {
     // Synced with (N)-th frame
-    trackerFile = std::make_shared<OF2TrackerFile>(trackerFilename, startFrame);
+    trackerStore = std::make_shared<TrackerStore>(trackerFilename, false);
+    trackerFrame = std::max(startFrame, 1L);
+    roi = std::make_shared<Rect2d>();
 
 }
 
@@ -87,18 +104,37 @@ void OF2DataBox::configFlow(const string& diagFilename,
         const TrackerData& trackerData) {
 
     DiagFile diagFile(diagFilename);
-    std::shared_ptr<AmplitudeFactor> amplitudeFactor = 
-            std::make_shared<AmplitudeFactor>(diagFile.getNext());
+    diagAmplitudeFactor = std::make_shared<AmplitudeFactor>(diagFile.getNext());
+
+    opticalFlow = createOpticalFlow();
 
-    opticalFlow = std::make_shared<OpticalFlow>(opticalFlowData, trackerData, amplitudeFactor);
+    if (opticalFlowData.sharedPyramid) {
+        pyramid = std::make_shared<FramePyramid>(
+                opticalFlowData.pyramidScale, opticalFlowData.pyramidLayers);
+        prevPyramid = std::make_shared<FramePyramid>(
+                opticalFlowData.pyramidScale, opticalFlowData.pyramidLayers);
+    }
 
 }
 
 bool OF2DataBox::update() {
+    // Make current gray previous gray. Every camera keeps it, so 
+    // flow can be calculated right after camera switch.
+    if (opticalFlowData.roiFlow) {
+        std::swap(prevFullFrame, fullFrame);
+    } else {
+        std::swap(uprevgray, ugray);
+    }
+    if (opticalFlowData.sharedPyramid) {
+        prevPyramid->swap(*pyramid);
+        prevPyramidBuilt = pyramidBuilt;
+        pyramidBuilt = false;
+    }
+    
     /// 
     /// VIDEO
     ///
-    if (!video->read(frame)) {
+    if (!video->read(fullFrame)) {
         cout << endl;
         cout << "=======================" << endl;
         cout << "Frame " << video->get(CAP_PROP_POS_FRAMES)
@@ -108,30 +144,57 @@ bool OF2DataBox::update() {
         return false;
     }
 
-    // Get gray frame for optical flow calculation
-    if (frame.empty()) {
+    // Frames not needed by selection plan are returned empty
+    bool skipped = fullFrame.empty() && selectionPlan;
+    if (fullFrame.empty() && !skipped) {
         throw Exception(__FILE__, __LINE__, "Frame is empty. Skipping it.");
     }
 
-    if (frame.channels() == 3) {
-        cvtColor(frame, ugray, COLOR_BGR2GRAY);
-
-    } else if (frame.channels() == 1) {
-        cout << "Frame is greyscale." << endl;
-        frame.copyTo(ugray);
+    // Get gray frame for optical flow calculation
+    // With ROI flow gray is calculated later only on padded ROI
+    if (skipped) {
+        // Flow from skipped frame is zero instead of flow from stale gray
+        ugray.release();
+        
+    } else if (!opticalFlowData.roiFlow) {
+        if (fullFrame.channels() == 3) {
+            cvtColor(fullFrame, ugray, COLOR_BGR2GRAY);
+
+        } else if (fullFrame.channels() == 1) {
+            // Gray video or luma decode
+            fullFrame.copyTo(ugray);
 
-    } else {
-        throw Exception(__FILE__, __LINE__, "Frame has oddly number of channels");
+        } else {
+            throw Exception(__FILE__, __LINE__, "Frame has oddly number of channels");
+        }
     }
 
-    if (trackerData.trackerDownScale > 0) {
-        Scaler::scaleFrame(frame, frame, trackerData.trackerDownScale);
+    if (skipped) {
+        frame = Mat();
+        
+    } else if (opticalFlowData.sharedPyramid) {
+        // Pyramid is built by calculateFlow(), only for selected camera
+        
+        // Scaled color frame is needed only for output video
+        if (!opticalFlowData.needVideo) {
+            frame = Mat();
+        } else if (trackerData.trackerDownScale > 0) {
+            Scaler::scaleFrame(fullFrame, frame, trackerData.trackerDownScale);
+        } else {
+            frame = fullFrame;
+        }
+        
+    } else if (trackerData.trackerDownScale > 0) {
+        // Gray with luma decode
+        Scaler::scaleFrame(fullFrame, frame, trackerData.trackerDownScale);
+    } else {
+        frame = fullFrame;
     }
 
     ///
     /// TRACKER
     /// 
-    roi = trackerFile->getNext();
+    *roi = trackerStore->get(trackerFrame++);
     if (Roi::isEmpty(*roi)) {
         confident = false;
     } else {
@@ -141,32 +204,45 @@ bool OF2DataBox::update() {
     /// 
     /// DEPTH
     ///  
-    depthInputSequence->getFilename(depthFilename);
-    depthImage = std::make_shared<DepthImage>(depthFilename);
-    metricCenter = Roi::getMetricCenter(*roi, depthImage->depth, homography);
-    depthImage.reset();
+    if (!selectionPlan) {
+        if (!depthSequence->getNext(depth)) {
+            string message = "Depth " + depthSequence->getName() + " not found.";
+            throw Exception(__FILE__, __LINE__, message);
+        }
+        depthFilename = depthSequence->getName();
+        metricCenter = Roi::getMetricCenter(*roi, depth, homography);
+        // Depth from PNG isn't kept between frames
+        depth.release();
+    }
 
     /// 
     /// TIMES 
     /// 
     timeStamp = timeFileReader->getNext();
 
+    return true;
+}
 
-
-
-    // If previous gray not empty calculate optical flow
-    if (!uprevgray.empty()) {
+void OF2DataBox::calculateFlow() {
+    // If previous frame not empty calculate optical flow
+    bool hasPrevious = opticalFlowData.roiFlow ? 
+        !prevFullFrame.empty() : !uprevgray.empty();
+    if (hasPrevious) {
+        Size prevSize = opticalFlowData.roiFlow ? 
+            prevFullFrame.size() : uprevgray.size();
+        Size currSize = opticalFlowData.roiFlow ? 
+            fullFrame.size() : ugray.size();
 
         // Something went wrong because sizes are different.
-        if (uprevgray.size() != ugray.size()) {
+        if (prevSize != currSize) {
             std::stringstream ss;
             ss << "Something went wrong because sizes of previous"
                     << "frame and current frame are different" << endl;
             ss << "Maybe the problem is in video " << videoFilename << endl;
             ss << "Previous frame size: "
-                    << uprevgray.rows << "x" << uprevgray.cols << endl;
+                    << prevSize.height << "x" << prevSize.width << endl;
             ss << "Current frame size: "
-                    << ugray.rows << "x" << ugray.cols << endl;
+                    << currSize.height << "x" << currSize.width << endl;
             ss << "Current timestamp in ms: "
                     << video->get(CAP_PROP_POS_MSEC) << endl;
             ss << "Next frame: "
@@ -177,26 +253,102 @@ bool OF2DataBox::update() {
         }
 
 
-        // If tracker is enabled and ROI is empty
-        // then histogram will be empty (All zero values).
-        // 1e-15 is double precision
-        if (confident) {
-            if (opticalFlow) {
-                opticalFlow->getPolarFlow(uprevgray, ugray, *roi, angle, magnitude);
-            } else {
-                string message = "No optical flow object!";
-                throw Exception(__FILE__, __LINE__, message);
+        if (!opticalFlow) {
+            string message = "No optical flow object!";
+            throw Exception(__FILE__, __LINE__, message);
+        }
+        
+        if (confident && opticalFlowData.sharedPyramid) {
+            buildPyramids();
+            opticalFlow->getPolarFlow(
+                    *prevPyramid, *pyramid, *roi, angle, magnitude);
+            
+            if (opticalFlowData.fusedHistogram) {
+                flow = opticalFlow->getFlow();
+                amplitudeFactor = opticalFlow->getAmplitudeFactor(*roi);
             }
+            
+        } else {
+            // Headers only, frames are not copied
+            FramePair pair;
+            pair.confident = confident;
+            pair.roi = *roi;
+            pair.prevGray = uprevgray;
+            pair.gray = ugray;
+            pair.prevFrame = prevFullFrame;
+            pair.frame = fullFrame;
+            
+            calculatePairFlow(*opticalFlow, opticalFlowData, pair, 
+                    angle, magnitude, flow, amplitudeFactor);
+        }
+    }
+
+}
 
+void OF2DataBox::calculatePairFlow(OpticalFlow& opticalFlow,
+        const OpticalFlowData& opticalFlowData,
+        const FramePair& pair,
+        Mat& angle, Mat& magnitude, Mat& flow, float& amplitudeFactor) {
+    
+    bool hasPrevious = opticalFlowData.roiFlow ? 
+        !pair.prevFrame.empty() : !pair.prevGray.empty();
+    
+    // If tracker is enabled and ROI is empty
+    // then histogram will be empty (All zero values).
+    // 1e-15 is double precision
+    if (pair.confident && hasPrevious) {
+        if (opticalFlowData.roiFlow) {
+            opticalFlow.getPolarRoiFlow(
+                    pair.prevFrame, pair.frame, pair.roi, angle, magnitude);
         } else {
-            // Type is same as type returned by calcOpticalFlowFarneback()
-            angle = Mat::zeros(roi->size(), CV_32FC1);
-            magnitude = Mat::zeros(roi->size(), CV_32FC1);
+            opticalFlow.getPolarFlow(pair.prevGray, pair.gray, pair.roi, angle, magnitude);
+        }
+
+        if (opticalFlowData.fusedHistogram) {
+            flow = opticalFlow.getFlow();
+            amplitudeFactor = opticalFlow.getAmplitudeFactor(pair.roi);
         }
+
+    } else {
+        // Type is same as type returned by calcOpticalFlowFarneback()
+        angle = Mat::zeros(pair.roi.size(), CV_32FC1);
+        magnitude = Mat::zeros(pair.roi.size(), CV_32FC1);
+    }
+}
+
+void OF2DataBox::getFramePair(FramePair& pair) const {
+    if (opticalFlowData.sharedPyramid) {
+        string message = "Frame pair is not kept with shared pyramid.";
+        throw Exception(__FILE__, __LINE__, message);
     }
+    
+    pair.confident = confident;
+    pair.roi = *roi;
+    if (opticalFlowData.roiFlow) {
+        prevFullFrame.copyTo(pair.prevFrame);
+        fullFrame.copyTo(pair.frame);
+    } else {
+        uprevgray.copyTo(pair.prevGray);
+        ugray.copyTo(pair.gray);
+    }
+}
 
-    // Make current gray previous gray
-    std::swap(uprevgray, ugray);
+std::shared_ptr<OpticalFlow> OF2DataBox::createOpticalFlow() const {
+    return std::make_shared<OpticalFlow>(opticalFlowData, trackerData, diagAmplitudeFactor);
+}
+void OF2DataBox::setFlowQuality(const FlowQuality& quality) {
+    opticalFlow->setQuality(quality);
+}
 
-    return true;
-}
\ No newline at end of file
+void OF2DataBox::buildPyramids() {
+    if (!prevPyramidBuilt) {
+        Mat prevGray = uprevgray.getMat(ACCESS_READ);
+        prevPyramid->build(prevGray);
+        prevPyramidBuilt = true;
+    }
+    if (!pyramidBuilt) {
+        Mat gray = ugray.getMat(ACCESS_READ);
+        pyramid->build(gray);
+        pyramidBuilt = true;
+    }
+}
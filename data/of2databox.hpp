@@ -27,10 +27,10 @@
 #include <sstream>
 
 #include "inputsequence.hpp"
-#include "of2trackerfile.hpp"
+#include "trackerstore.hpp"
 #include "timefilereader.hpp"
 #include "exception.hpp"
-#include "depthimage.hpp"
+#include "depthsequence.hpp"
 #include "framespeed.hpp"
 #include "roi.hpp"
 #include "of2terminalparser.hpp"
@@ -42,29 +42,60 @@
 #include "scaler.hpp"
 #include "depthimage.hpp"
 #include "basedatabox.hpp"
-#include "basetrackerfile.hpp"
 #include "roi.hpp"
+#include "framepyramid.hpp"
+#include "framedecoder.hpp"
+#include "selectionplanfile.hpp"
 
 using namespace std;
 
 namespace gk {
 
+    // Frame pair of one camera copied out of data box, so that its flow 
+    // can be calculated on other thread while data box reads next frames
+    struct FramePair {
+        bool confident;
+        Rect2d roi;
+        // Gray frames, or full resolution frames with ROI flow
+        UMat prevGray, gray;
+        Mat prevFrame, frame;
+    };
+
     class OF2DataBox : public BaseDataBox{
     private:
         OpticalFlowData opticalFlowData;
         TrackerData trackerData;
         string videoFilename;
         
-        std::shared_ptr<InputSequence> depthInputSequence;
-        std::shared_ptr<DepthImage> depthImage;
+        // PNG sequence or depth container
+        std::shared_ptr<DepthSequence> depthSequence;
+        Mat depth;
 
         std::shared_ptr<TimeFileReader> timeFileReader;
 
-        std::shared_ptr<BaseTrackerFile> trackerFile;
+        std::shared_ptr<TrackerStore> trackerStore;
+        // Synced with (N)-th frame
+        long trackerFrame;
         std::shared_ptr<OpticalFlow> opticalFlow;
+        // From diag file, shared by all flow states of this camera
+        std::shared_ptr<AmplitudeFactor> diagAmplitudeFactor;
         
         UMat ugray, uprevgray;
         
+        // Full resolution frames, needed when flow is calculated only on ROI
+        Mat fullFrame, prevFullFrame;
+        
+        // Gray pyramids of frame N and N-1, used with shared pyramid. They
+        // are built only when flow of camera is calculated, so pyramid of
+        // N-1 is missing if camera wasn't selected for previous frame.
+        std::shared_ptr<FramePyramid> pyramid, prevPyramid;
+        bool pyramidBuilt, prevPyramidBuilt;
+        
+        // With selection plan only needed frames are decoded and depth 
+        // isn't loaded, because metric center isn't needed
+        std::shared_ptr<SelectionPlan> selectionPlan;
+        int camera;
+        
 
         void configInput(const string& imageFilename,
                 const string& depthFilename,
@@ -78,6 +109,11 @@ namespace gk {
                 const OpticalFlowData& opticalFlowData,
                 const TrackerData& trackerData);
         
+        /**
+         * Builds pyramids of frame N and N-1 that are missing.
+         */
+        void buildPyramids();
+        
     public:
         Mat frame;
         string depthFilename;
@@ -85,10 +121,14 @@ namespace gk {
         Size matrixSize;
 
         std::shared_ptr<Rect2d> roi;
+        // Cartesian flow in ROI and its amplitude factor, used with fused histogram
+        Mat flow;
+        float amplitudeFactor;
         Point3d metricCenter;
         bool confident;
 
-        std::shared_ptr<VideoCapture> video;
+        // Owns VideoCapture and decodes frames ahead
+        std::shared_ptr<FrameDecoder> video;
         std::shared_ptr<VideoTimer> timer;
         int codecNum;
         double fps;
@@ -104,9 +144,36 @@ namespace gk {
                 const string& diagFilename,
                 const long startFrame,
                 const OpticalFlowData& opticalFlowData,
-                const TrackerData& trackerData);
+                const TrackerData& trackerData,
+                const std::shared_ptr<SelectionPlan>& selectionPlan = NULL,
+                const int camera = 0);
 
         bool update() override;
+        
+        void calculateFlow() override;
+        
+        void setFlowQuality(const FlowQuality& quality);
+        
+        /**
+         * Copies frames of last two update() calls. Not available with 
+         * shared pyramid, which keeps pyramids instead of frames.
+         */
+        void getFramePair(FramePair& pair) const;
+        
+        /**
+         * New flow state for this camera, for flow calculated outside of
+         * data box.
+         */
+        std::shared_ptr<OpticalFlow> createOpticalFlow() const;
+        
+        /**
+         * Same as calculateFlow() without shared pyramid, but on copied 
+         * frame pair. Flow is zero if pair has no previous frame.
+         */
+        static void calculatePairFlow(OpticalFlow& opticalFlow,
+                const OpticalFlowData& opticalFlowData,
+                const FramePair& pair,
+                Mat& angle, Mat& magnitude, Mat& flow, float& amplitudeFactor);
 
     };
 }
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "selectionplanner.hpp"
+
+using namespace gk;
+
+SelectionPlanner::SelectionPlanner(const vector<string>& depthFilenames,
+        const vector<string>& trackerFilenames,
+        const vector<string>& intrinsicFilenames,
+        const vector<string>& extrinsicFilenames,
+        const CameraSelectorData& cameraSelectorData,
+        const long startFrame,
+        const bool sceneFlowTracker,
+        const int prefetchDepth,
+        const int prefetchThreads)
+: cameraSelector(cameraSelectorData) {
+
+    size_t cameraCount = depthFilenames.size();
+    if (trackerFilenames.size() != cameraCount ||
+            intrinsicFilenames.size() != cameraCount ||
+            extrinsicFilenames.size() != cameraCount) {
+        throw Exception(__FILE__, __LINE__, "Every camera needs depth, tracker, intrinsic and extrinsic file.");
+    }
+
+    // First frame has no flow
+    firstFrame = std::max(startFrame, 1L) + 1;
+
+    for (size_t i = 0; i < cameraCount; i++) {
+        Camera camera;
+        camera.depthSequence = std::make_shared<DepthSequence>(depthFilenames[i], firstFrame,
+                prefetchDepth, prefetchThreads);
+        camera.trackerStore = std::make_shared<TrackerStore>(trackerFilenames[i], sceneFlowTracker);
+
+        IntrinsicFile intrinsicFile(intrinsicFilenames[i]);
+        ExtrinsicFile extrinsicFile(extrinsicFilenames[i]);
+        CameraCalib cameraCalib(intrinsicFile.getNext(), extrinsicFile.getNext());
+        cameraCalib.homography.copyTo(camera.homography);
+
+        cameras.push_back(camera);
+    }
+}
+
+SelectionPlan SelectionPlanner::plan(const long frameCount) {
+    SelectionPlan selectionPlan(firstFrame);
+    vector<Point3d> metricCenters(cameras.size());
+    Mat depth;
+
+    for (long f = 0; frameCount < 0 || f < frameCount; f++) {
+        for (size_t i = 0; i < cameras.size(); i++) {
+            if (!cameras[i].depthSequence->getNext(depth)) {
+                cout << endl;
+                cout << "Depth " << cameras[i].depthSequence->getName() << " not found. Plan ends." << endl;
+                return selectionPlan;
+            }
+            Rect2d roi = cameras[i].trackerStore->get(firstFrame + f);
+            metricCenters[i] = Roi::getMetricCenter(roi, depth, cameras[i].homography);
+        }
+        selectionPlan.add(cameraSelector.select(metricCenters));
+
+        if (f % 100 == 0) {
+            printf("\rFrame: %ld", firstFrame + f);
+            fflush(stdout);
+        }
+    }
+    cout << endl;
+    return selectionPlan;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SELECTIONPLANNER_HPP
+#define SELECTIONPLANNER_HPP
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <iostream>
+
+#include "trackerstore.hpp"
+#include "intrinsicfile.hpp"
+#include "extrinsicfile.hpp"
+#include "cameracalib.hpp"
+#include "cameraselector.hpp"
+#include "depthsequence.hpp"
+#include "roi.hpp"
+#include "selectionplanfile.hpp"
+#include "exception.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Runs camera selection over whole recording. Selection depends only
+     * on tracker boxes, depth images, calibration and selector config, so
+     * it is done once, before features are calculated.
+     * 
+     * Like in feature binaries, first frame has no flow and selection 
+     * starts with frame after start frame.
+     */
+    class SelectionPlanner {
+    private:
+        struct Camera {
+            std::shared_ptr<DepthSequence> depthSequence;
+            std::shared_ptr<TrackerStore> trackerStore;
+            Mat homography;
+        };
+
+        vector<Camera> cameras;
+        CameraSelector cameraSelector;
+        long firstFrame;
+
+    public:
+        /**
+         * @param sceneFlowTracker Tracker files have confidence column, as
+         * in scene flow features.
+         * @param prefetchDepth Depth PNG frames decoded ahead for every 
+         * camera.
+         */
+        SelectionPlanner(const vector<string>& depthFilenames,
+                const vector<string>& trackerFilenames,
+                const vector<string>& intrinsicFilenames,
+                const vector<string>& extrinsicFilenames,
+                const CameraSelectorData& cameraSelectorData,
+                const long startFrame,
+                const bool sceneFlowTracker,
+                const int prefetchDepth = 0,
+                const int prefetchThreads = 1);
+
+        /**
+         * @param frameCount Frames to plan. If -1 until depth images of 
+         * one camera end.
+         */
+        SelectionPlan plan(const long frameCount = -1);
+    };
+}
+
+#endif /* SELECTIONPLANNER_HPP */
+
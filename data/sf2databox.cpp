@@ -29,8 +29,11 @@ SF2DataBox::SF2DataBox(const string& imageFilename,
         const string& intrinsicFilename,
         const string& extrinsicFilename,
         const long startFrame,
-        const SceneFlowData& sceneFlowData)
-: BaseDataBox(startFrame), sceneFlowData(sceneFlowData){
+        const SceneFlowData& sceneFlowData,
+        const std::shared_ptr<SelectionPlan>& selectionPlan,
+        const int camera)
+: BaseDataBox(startFrame), sceneFlowData(sceneFlowData), firstUpdate(true),
+selectionPlan(selectionPlan), camera(camera){
 
     configInput( imageFilename, depthFilename, startFrame);
     configTracker(trackerFilename, startFrame);
@@ -43,17 +46,19 @@ void SF2DataBox::configInput(const string& imageFilename,
         const string& depthFilename, 
         const long startFrame) {
     
-    // N-th and (N+1)-th frame
-    imageInputSequence = vector<std::shared_ptr<InputSequence>>(2);
-    depthInputSequence = vector<std::shared_ptr<InputSequence>>(2);
-    
-    for(int i=0; i < imageInputSequence.size(); i++){
-        imageInputSequence[i] = 
-                std::make_shared<InputSequence>(imageFilename, startFrame + i);
-        depthInputSequence[i] = 
-                std::make_shared<InputSequence>(depthFilename, startFrame + i);
+    // One sequence from N-th frame on, frames slide from (N+1)-th to N-th
+    long firstFrame = std::max(startFrame, 1L);
+    vector<bool> neededFrames;
+    if (selectionPlan) {
+        neededFrames = selectionPlan->getNeededFrames(camera, firstFrame);
     }
     
+    imagePrefetcher = std::make_shared<ImagePrefetcher>(imageFilename, firstFrame,
+            sceneFlowData.prefetchDepth, sceneFlowData.prefetchThreads,
+            neededFrames, IMREAD_GRAYSCALE);
+    depthSequence = std::make_shared<DepthSequence>(depthFilename, firstFrame,
+            sceneFlowData.prefetchDepth, sceneFlowData.prefetchThreads, neededFrames);
+    
     imageFilenames = vector<string>(2);
     depthFilenames = vector<string>(2);
 }
@@ -61,17 +66,24 @@ void SF2DataBox::configInput(const string& imageFilename,
 
 void SF2DataBox::configTracker(const string& trackerFilename, const long startFrame){
     // Synced with (N+1)-th frame
-    trackerFile = std::make_shared<SF2TrackerFile>(trackerFilename, startFrame + 1);
+    trackerStore = std::make_shared<TrackerStore>(trackerFilename, true);
+    trackerFrame = std::max(startFrame + 1, 1L);
+    roi = std::make_shared<Rect2d>();
     
 }
 
 void SF2DataBox::configTime(const string& timeFilename, const long startFrame){
     
-    // N-th and (N+1)-th frame
+    // N-th and (N+1)-th frame, both seek with one index
+    std::shared_ptr<const LineIndex> lineIndex;
+    if (startFrame >= 1 && boost::filesystem::exists(timeFilename)) {
+        lineIndex = LineIndex::get(timeFilename);
+    }
+    
     timeFileReaders = vector<std::shared_ptr<TimeFileReader>>(2);
     for (int i = 0; i < timeFileReaders.size(); i++) {
-        timeFileReaders[i] =
-                std::make_shared<TimeFileReader>(timeFilename, startFrame + i);
+        timeFileReaders[i] = std::make_shared<TimeFileReader>(timeFilename, 
+                startFrame + i, lineIndex);
     } 
     
     frameSpeed = std::make_shared<FrameSpeed>();
@@ -79,32 +91,44 @@ void SF2DataBox::configTime(const string& timeFilename, const long startFrame){
 
 
 
+bool SF2DataBox::loadFrame(const int i) {
+    // Runs on camera threads, so errors are thrown instead of exit()
+    if (!imagePrefetcher->getNext(frames[i].intensity)) {
+        if (i == 1) {
+            // No file found. Probably last file.
+            return false;
+        }
+        throw Exception(__FILE__, __LINE__, "First BGR image not found. File: " 
+                + imagePrefetcher->getFilename());
+    }
+    imageFilenames[i] = imagePrefetcher->getFilename();
+    
+    if (!depthSequence->getNext(frames[i].depth)) {
+        throw Exception(__FILE__, __LINE__, "DEPTH image not found, but BGR image exists! File: " 
+                + depthSequence->getName());
+    }
+    depthFilenames[i] = depthSequence->getName();
+    return true;
+}
+
 bool SF2DataBox::update(){
     
-    // Update image filenames
-    // Update depth filenames
+    // Update images and depth
+    // (N+1)-th frame of last update is N-th frame now
+    if (firstUpdate) {
+        loadFrame(0);
+        firstUpdate = false;
+    } else {
+        frames[0] = frames[1];
+        imageFilenames[0] = imageFilenames[1];
+        depthFilenames[0] = depthFilenames[1];
+    }
+    if (!loadFrame(1)) {
+        return false;
+    }
+    
     // Update time stamps
     for(int i=0; i<2; i++){
-        if (!imageInputSequence[i]->getFilename(imageFilenames[i])) {
-            if (i == 1) {
-                // No file found. Probably last file.
-                cout << "Second BGR image not found." << endl;
-                cout << "Last file: " << imageFilenames[0] << endl;
-                cout << "EXIT SUCCESS.";
-                exit(EXIT_SUCCESS);
-            } else {
-                cerr << "First BGR image not found." << endl;
-                cerr << "File: " << imageFilenames[0] << endl;
-                cerr << "EXIT FAILURE";
-                exit(EXIT_FAILURE);
-            }
-        }
-        if (!depthInputSequence[i]->getFilename(depthFilenames[i])) {
-            cerr << "DEPTH image not found, but BGR image exists!" << endl;
-            cerr << "File: " << depthFilenames[0] << endl;
-            cerr << "EXIT FAILURE";
-            exit(EXIT_FAILURE);
-        }
         timeStamps[i] = timeFileReaders[i]->getNext();       
     }
     
@@ -114,7 +138,7 @@ bool SF2DataBox::update(){
     
     
     // Update roi
-    roi = trackerFile->getNext();
+    *roi = trackerStore->get(trackerFrame++);
     if (roi->area() > 0) {
         confident = true;
 
@@ -123,20 +147,22 @@ bool SF2DataBox::update(){
     }
     
     
-    if(confident){
-        // Calculate scene flow   
-        calculateSceneFlow();
-    }
-    
     // Update metric center
     // Update depth
     // synced with (N+1)-th frame
-    depthImage = std::make_shared<DepthImage>(depthFilenames[1]);
-    metricCenter = Roi::getMetricCenter(*roi, depthImage->depth, homography);
-    depthImage.reset();
+    if (!selectionPlan) {
+        metricCenter = Roi::getMetricCenter(*roi, frames[1].depth, homography);
+    }
     
+    return true;
+}
+
+void SF2DataBox::calculateFlow(){
     if(confident){
-        if (trackerFile) {
+        // Calculate scene flow   
+        calculateSceneFlow();
+        
+        if (trackerStore) {
             velocityMatrix->cropVelocityMatrix(*roi);
         }
         
@@ -152,23 +178,19 @@ bool SF2DataBox::update(){
             exit(EXIT_FAILURE);
         }
     }
-    
-    return true;
 }
 
 
 void SF2DataBox::calculateSceneFlow(){
     sceneflow = std::make_shared<PD_flow_opencv>(sceneFlowData.rows,
-            sceneFlowData.ctf,
-            imageFilenames[0].c_str(),
-            imageFilenames[1].c_str(),
-            depthFilenames[0].c_str(),
-            depthFilenames[1].c_str());
+            sceneFlowData.ctf);
 
     matrixSize = Size(sceneflow->cols, sceneflow->rows);
 
-    sceneflow->initializeCUDA();
-    if (sceneflow->loadRGBDFrames()) {
+    // Frames decoded by update()
+    sceneflow->initializeCUDA(frames[0].intensity.size());
+    if (sceneflow->loadRGBDFrames(frames[0].intensity, frames[0].depth,
+            frames[1].intensity, frames[1].depth)) {
         sceneflow->solveSceneFlowGPU();
         
         velocityMatrix = std::make_shared<VelocityMatrix>(sceneflow->dxp, sceneflow->dyp,
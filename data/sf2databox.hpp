@@ -25,16 +25,16 @@
 #include <string>
 #include <sstream>
 
-#include "inputsequence.hpp"
-#include "sf2trackerfile.hpp"
+#include "trackerstore.hpp"
 #include "timefilereader.hpp"
 #include "exception.hpp"
-#include "depthimage.hpp"
+#include "depthsequence.hpp"
 #include "framespeed.hpp"
 #include "roi.hpp"
 #include "sf2terminalparser.hpp"
 #include "velocitymatrix.hpp"
 #include "basedatabox.hpp"
+#include "selectionplanfile.hpp"
 
 #include "scene_flow_impair.h"
 
@@ -44,18 +44,35 @@ namespace gk{
     private:
         SceneFlowData sceneFlowData;
         
-        std::vector< std::shared_ptr<InputSequence> > imageInputSequence;
-        std::vector< std::shared_ptr<InputSequence> > depthInputSequence;
-        std::shared_ptr<DepthImage> depthImage;
+        // Decoded gray intensity and 16-bit depth
+        struct RGBDFrame {
+            Mat intensity;
+            Mat depth;
+        };
+        
+        std::shared_ptr<ImagePrefetcher> imagePrefetcher;
+        std::shared_ptr<DepthSequence> depthSequence;
+        // N-th and (N+1)-th frame. (N+1)-th frame becomes N-th frame on 
+        // next update, so every image is decoded once. Scene flow and 
+        // metric center read them.
+        RGBDFrame frames[2];
+        bool firstUpdate;
         
         std::vector< std::shared_ptr<TimeFileReader> > timeFileReaders;
         float fps;
 
-        std::shared_ptr<BaseTrackerFile> trackerFile;
+        std::shared_ptr<TrackerStore> trackerStore;
+        // Synced with (N+1)-th frame
+        long trackerFrame;
         std::shared_ptr<FrameSpeed> frameSpeed;
         std::shared_ptr<PD_flow_opencv> sceneflow;
         std::shared_ptr<VelocityMatrix> velocityMatrix;
         
+        // With selection plan depth isn't loaded for metric center and 
+        // only frames of selected camera are decoded
+        std::shared_ptr<SelectionPlan> selectionPlan;
+        int camera;
+        
         void configInput(const string& imageFilename,
                 const string& depthFilename,
                 const long startFrame) override;
@@ -66,6 +83,12 @@ namespace gk{
         
         void calculateSceneFlow();
         
+        /**
+         * @return False if sequence has no more frames. Missing first or 
+         * depth image throws.
+         */
+        bool loadFrame(const int i);
+        
     public:
         std::vector<string> imageFilenames;
         std::vector<string> depthFilenames;
@@ -83,10 +106,14 @@ namespace gk{
                 const string& intrinsicFilename,
                 const string& extrinsicFilename,
                 const long startFrame,
-                const SceneFlowData& sceneFlowData);
+                const SceneFlowData& sceneFlowData,
+                const std::shared_ptr<SelectionPlan>& selectionPlan = NULL,
+                const int camera = 0);
         
         bool update() override;
         
+        void calculateFlow() override;
+        
     };
 }
 
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// std
+#include <iostream>
+#include <string>
+#include <memory>
+
+// opencv
+#include <opencv2/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+// local
+#include "packterminalparser.hpp"
+#include "inputsequence.hpp"
+#include "timefilereader.hpp"
+#include "depthcontainer.hpp"
+#include "config.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace gk;
+
+static void printErrorHeader(int line) {
+    cerr << endl;
+    cerr << "File: " << __FILE__ << " line: " << line << endl;
+}
+
+static void printErrorFooter() {
+    cerr << "Aborting program..." << endl;
+    cerr << endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @return Packed frames.
+ */
+static long pack(const string& depthFilename, const string& timeFilename,
+        const string& outFilename, const long startFrame, const long frameCount) {
+    
+    InputSequence depthSequence(depthFilename, startFrame);
+    std::shared_ptr<TimeFileReader> timeFile;
+    if (!timeFilename.empty()) {
+        timeFile = std::make_shared<TimeFileReader>(timeFilename, startFrame);
+    }
+    
+    // Frame size is known after first frame
+    std::shared_ptr<DepthContainerWriter> container;
+    string filename;
+    long f = 0;
+    for (; frameCount < 0 || f < frameCount; f++) {
+        if (!depthSequence.getFilename(filename)) {
+            break;
+        }
+        
+        // Raw 16-bit millimeters, as DepthImage reads them
+        Mat depth = imread(filename, -1);
+        if (depth.empty() || depth.type() != CV_16UC1) {
+            throw Exception(__FILE__, __LINE__, "Depth image " + filename + " is not 16-bit.");
+        }
+        if (!container) {
+            container = std::make_shared<DepthContainerWriter>(outFilename, depth.size(), startFrame);
+        }
+        container->write(depth, timeFile ? timeFile->getNext() : 0);
+        
+        if (f % 100 == 0) {
+            printf("\rFrame: %ld", startFrame + f);
+            fflush(stdout);
+        }
+    }
+    cout << endl;
+    
+    if (!container) {
+        throw Exception(__FILE__, __LINE__, "No depth images found for " + depthFilename);
+    }
+    container->close();
+    return f;
+}
+
+int main(int argc, char** argv) {
+
+    /// TERMINAL PARSER
+    PackTerminalParser terminalParser = PackTerminalParser(argc, const_cast<const char**> (argv), VERSION_MAJOR, VERSION_MINOR);
+    try {
+        terminalParser.parseInput();
+    } catch (std::exception& e) {
+        printErrorHeader(__LINE__);
+        cerr << e.what() << endl;
+        printErrorFooter();
+    }
+    /// TERMINAL PARSER
+
+
+    /// PACK
+    // Frames keep sequence numbers, so containers replace sequence paths
+    // with same --start-frame
+    try {
+        for (size_t i = 0; i < terminalParser.depthFilenames.size(); i++) {
+            string timeFilename = terminalParser.timeFilenames.empty() ? 
+                "" : terminalParser.timeFilenames[i];
+            
+            cout << "=======================" << endl;
+            cout << "Packing " << terminalParser.depthFilenames[i] << "..." << endl;
+            long packed = pack(terminalParser.depthFilenames[i], timeFilename,
+                    terminalParser.outFilenames[i],
+                    terminalParser.startFrame, terminalParser.frameCount);
+            cout << "Packed frames: " << packed << " to " << terminalParser.outFilenames[i] << endl;
+        }
+    } catch (std::exception& e) {
+        printErrorHeader(__LINE__);
+        cerr << e.what() << endl;
+        printErrorFooter();
+    }
+    /// PACK
+
+    return 0;
+}
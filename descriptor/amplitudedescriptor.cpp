@@ -43,35 +43,12 @@ void AmplitudeDescriptor::getHistogram(
     
     // Clear descriptor
     normalizedHistogram.clear();
-    vector<float> descriptor(binCount);
+    vector<float> descriptor;
     
-    float pixValue;
-    unsigned int binValue;
+    // Same binning as before, vectorized for available ISA
+    HistogramKernels::amplitudeHistogram(
+            amplitude, scaleAmplitude, minAmplitude, binCount, descriptor);
     
-    const float* row;
-    for(int y = 0; y < amplitude.rows; y++){
-
-        row = amplitude.ptr<float>(y);
-        for(int x = 0; x < amplitude.cols; x++){
-            /* Make sure amplitudes are positive values */
-            pixValue = row[x] * row[x];
-            pixValue = sqrt(pixValue) * scaleAmplitude;
-            
-            /* Skip everything below minAmplitude, do NOT saturate */
-            if (pixValue >= minAmplitude){
-                pixValue = pixValue - minAmplitude;
-
-                /* Chop off the fractional part (rounding towards zero) */ 
-                binValue = (unsigned int)pixValue;
-
-                /* Clip at top end, do NOT saturate */
-                if (binValue < binCount){
-                    /* We count by ONE */
-                    descriptor.at(binValue) += 1.0;
-                }
-            }
-        }        
-    }
     // Normalize to probability. This means, sum of all descriptors is maxNormRange
     if (maxNormRange > 0){
         cv::normalize(descriptor, normalizedHistogram, maxNormRange, 0.0, NORM_L1);
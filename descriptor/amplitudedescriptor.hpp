@@ -23,12 +23,15 @@
 #include <vector>
 
 #include "basedescriptor.hpp"
+#include "histogramkernels.hpp"
 
 using namespace std;
 using namespace cv;
 
 namespace gk{
     class AmplitudeDescriptor : public BaseDescriptor{
+        friend class FlowDescriptor;
+        
     private:
         float minAmplitude;
         float scaleAmplitude;
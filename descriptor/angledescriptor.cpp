@@ -22,6 +22,8 @@ using namespace gk;
 
 const float AngleDescriptor::MIN_VALUE = - CV_PI/2;
 const float AngleDescriptor::MAX_VALUE = CV_PI/2;
+const float AngleDescriptor::EDGE_MARGIN = 1e-3;
+const float AngleDescriptor::TINY_FLOW = 1e-10;
 
 
 AngleDescriptor::AngleDescriptor(const DescriptorData& data) 
@@ -33,6 +35,19 @@ AngleDescriptor::AngleDescriptor(int binCount, float maxNormRange)
 	: BaseDescriptor(binCount, maxNormRange){
 
 	this->binWidth = (MAX_VALUE - MIN_VALUE)/binCount;
+
+    // First and last edge are exactly vertical
+    edgeSin.resize(binCount + 1);
+    edgeCos.resize(binCount + 1);
+    for(int k = 0; k <= binCount; k++){
+        double edge = MIN_VALUE + k*(double)binWidth;
+        edgeSin[k] = (float) std::sin(edge);
+        edgeCos[k] = (float) std::cos(edge);
+    }
+    edgeSin[0] = -1;
+    edgeCos[0] = 0;
+    edgeSin[binCount] = 1;
+    edgeCos[binCount] = 0;
 }
 
 void AngleDescriptor::getHistogram(
@@ -45,19 +60,25 @@ void AngleDescriptor::getHistogram(
     int bin;
     const float* row;
 
-    for(int y = 0; y < angles.rows; y++){
+    if(angles.type() == CV_32FC2){
+        // Cartesian flow, bins without atan2
+        const float* magnitudeRow;
+        for(int y = 0; y < angles.rows; y++){
 
-        row = angles.ptr<float>(y);
-        for(int x = 0; x < angles.cols; x++){
+            row = angles.ptr<float>(y);
+            magnitudeRow = magnitudes.ptr<float>(y);
+            for(int x = 0; x < angles.cols; x++){
 
-                bin = calculateBin(row[x]);
-                //if(bin < 0 || bin > binCount){
-                    //throw BinOutOfRangeException(CLASS_NAME, 57, bin, y, x, row[x]);
-                //}
+                bin = calculateBin(row[2*x], row[2*x + 1]);
                 if(bin > 0 && bin < binCount){
-                    histogram.at(bin) += magnitudes.at<float>(y,x);
+                    histogram[bin] += magnitudeRow[x];
                 }
+            }
         }
+
+    } else{
+        HistogramKernels::angleHistogram(
+                angles, magnitudes, MIN_VALUE, binWidth, binCount, histogram);
     }
 
     if(maxNormRange > 0){
@@ -73,36 +94,66 @@ int AngleDescriptor::calculateBin(float angle) const{
 	return cvFloor((angle - MIN_VALUE)/binWidth);
 }
 
+int AngleDescriptor::calculateBin(float dx, float dy) const{
+    // Normalized angle is angle of (|dx|, dy), so edge k is below vector
+    // when dy*cos - |dx|*sin >= 0. This decreases with k.
+    float adx = std::abs(dx);
+    int lo = 0, hi = binCount;
+    while(lo < hi){
+        int mid = (lo + hi + 1)/2;
+        if(dy*edgeCos[mid] - adx*edgeSin[mid] >= 0){
+            lo = mid;
+        } else{
+            hi = mid - 1;
+        }
+    }
+
+    // Distance to edge is at least margin*|(dx, dy)|, otherwise use angle
+    float margin = EDGE_MARGIN*(adx + std::abs(dy));
+    bool nearEdge = std::max(adx, std::abs(dy)) < TINY_FLOW ||
+            std::abs(dy*edgeCos[lo] - adx*edgeSin[lo]) <= margin;
+    if(lo < (int) binCount){
+        nearEdge = nearEdge || 
+                std::abs(dy*edgeCos[lo + 1] - adx*edgeSin[lo + 1]) <= margin;
+    }
+    if(nearEdge){
+        // Same as cartToPolar()
+        float angle = fastAtan2(dy, dx)*(float)(CV_PI/180);
+        return calculateBin(normalizeAngle(angle));
+    }
+    return lo;
+}
+
 void AngleDescriptor::normalizeAngles(Mat& flowAngles){
     
     float* row;
     for(int y = 0; y < flowAngles.rows; y++ ){
 
         row = flowAngles.ptr<float>(y);
-        int x = 0;
-        while(x < flowAngles.cols){
-
-            float angle = row[x];
-
-            // If angle is on interval (90°, 270°] (II. or III. quadrant)
-            // on the left side of vertical line
-            // move it to correspondent right side of vertical line, that is,
-            // convert it to intverval (90°, -90°]
-            if(angle > CV_PI/2 && angle <= 3*CV_PI/2){
-                row[x] = CV_PI - angle;
-
-            // If angle is on interval (270°, 360°] (in IV. quadrant)
-            // convert it to interval (-90, 0]
-            } else if(angle > 3*CV_PI/2 && angle <= 2*CV_PI ){
-                row[x] = angle - 2*CV_PI;
-
-            // If angle > 360° change it to interval [0°, 360°]
-            // and repeat the process.
-            } else if(angle > 2*CV_PI){
-                row[x] = angle - 2*CV_PI;
-                continue;
-            }
-            x++;
+        for(int x = 0; x < flowAngles.cols; x++){
+            row[x] = normalizeAngle(row[x]);
         }
     }
+}
+
+float AngleDescriptor::normalizeAngle(float angle){
+
+    // If angle > 360° change it to interval [0°, 360°]
+    while(angle > 2*CV_PI){
+        angle = angle - 2*CV_PI;
+    }
+
+    // If angle is on interval (90°, 270°] (II. or III. quadrant)
+    // on the left side of vertical line
+    // move it to correspondent right side of vertical line, that is,
+    // convert it to intverval (90°, -90°]
+    if(angle > CV_PI/2 && angle <= 3*CV_PI/2){
+        angle = CV_PI - angle;
+
+    // If angle is on interval (270°, 360°] (in IV. quadrant)
+    // convert it to interval (-90, 0]
+    } else if(angle > 3*CV_PI/2 && angle <= 2*CV_PI ){
+        angle = angle - 2*CV_PI;
+    }
+    return angle;
 }
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include <iostream>
 
 #include "basedescriptor.hpp"
+#include "histogramkernels.hpp"
 
 using namespace cv;
 using namespace std;
@@ -32,20 +33,48 @@ namespace gk{
     
     
     class AngleDescriptor : public BaseDescriptor {
+        friend class FlowDescriptor;
+        
         private:
             float binWidth;
             static const float MIN_VALUE;
             static const float MAX_VALUE;
+            
+            // Vectors closer than this (in radians) to bin edge are binned
+            // from angle. It is larger than error of fastAtan2().
+            static const float EDGE_MARGIN;
+            
+            // fastAtan2() adds DBL_EPSILON to divisor, so angles of smaller
+            // vectors are off by more than margin and are binned from angle
+            static const float TINY_FLOW;
+            
+            // Sine and cosine of bin edges, from MIN_VALUE to MAX_VALUE
+            vector<float> edgeSin, edgeCos;
 
             int calculateBin(float angle) const;      
+            
+            /**
+             * Same bin as calculateBin() of normalized cartToPolar() angle,
+             * but found from (dx, dy) with sign tests against bin edges.
+             * Vectors near edge, including zero, vertical and tiny 
+             * vectors, fall back to angle, so bins are bit-compatible.
+             */
+            int calculateBin(float dx, float dy) const;
 
         public:            
             AngleDescriptor(const DescriptorData& data);
             AngleDescriptor(int binCount, float maxNormRange);
 
+            /**
+             * @param angles Normalized angles (CV_32FC1) or Cartesian flow 
+             * (CV_32FC2). Cartesian flow is binned without atan2 and 
+             * doesn't need normalizeAngles().
+             */
             void getHistogram(const Mat& angles, const Mat& magnitudes, vector<float>& histogram);
 
             static void normalizeAngles(Mat& flowAngles);
+            
+            static float normalizeAngle(float angle);
     };
 }
 
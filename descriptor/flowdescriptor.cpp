@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "flowdescriptor.hpp"
+
+using namespace gk;
+
+FlowDescriptor::FlowDescriptor(std::shared_ptr<AngleDescriptor> angleDescriptor,
+        std::shared_ptr<AmplitudeDescriptor> amplitudeDescriptor)
+: angleDescriptor(angleDescriptor), amplitudeDescriptor(amplitudeDescriptor){
+    
+}
+
+void FlowDescriptor::getHistograms(const Mat& flow, float amplitudeFactor,
+        vector<float>& normalizedAngleHistogram, 
+        vector<float>& normalizedAmplitudeHistogram) const{
+    
+    CV_Assert(flow.empty() || flow.type() == CV_32FC2);
+    
+    normalizedAngleHistogram.clear();
+    normalizedAmplitudeHistogram.clear();
+    
+    const AngleDescriptor* angles = angleDescriptor.get();
+    const AmplitudeDescriptor* amplitudes = amplitudeDescriptor.get();
+    
+    vector<float> angleHistogram(angles ? angles->binCount : 0);
+    vector<float> amplitudeHistogram(amplitudes ? amplitudes->binCount : 0);
+    
+    const float* row;
+    for(int y = 0; y < flow.rows; y++){
+        
+        row = flow.ptr<float>(y);
+        for(int x = 0; x < flow.cols; x++){
+            float dx = row[2*x];
+            float dy = row[2*x + 1];
+            
+            float magnitude = std::sqrt(dx*dx + dy*dy) * amplitudeFactor;
+            
+            if(angles){
+                int bin = angles->calculateBin(dx, dy);
+                if(bin > 0 && bin < (int) angles->binCount){
+                    angleHistogram[bin] += magnitude;
+                }
+            }
+            
+            if(amplitudes){
+                float pixValue = magnitude * magnitude;
+                pixValue = sqrt(pixValue) * amplitudes->scaleAmplitude;
+                
+                if(pixValue >= amplitudes->minAmplitude){
+                    pixValue = pixValue - amplitudes->minAmplitude;
+                    unsigned int binValue = (unsigned int)pixValue;
+                    
+                    if(binValue < amplitudes->binCount){
+                        amplitudeHistogram[binValue] += 1.0;
+                    }
+                }
+            }
+        }
+    }
+    
+    if(angles){
+        if(angles->maxNormRange > 0){
+            normalize(angleHistogram, normalizedAngleHistogram, angles->maxNormRange, 0.0, NORM_L1);
+        } else{
+            normalizedAngleHistogram = angleHistogram;
+        }
+    }
+    if(amplitudes){
+        if(amplitudes->maxNormRange > 0){
+            normalize(amplitudeHistogram, normalizedAmplitudeHistogram, amplitudes->maxNormRange, 0.0, NORM_L1);
+        } else{
+            normalizedAmplitudeHistogram = amplitudeHistogram;
+        }
+    }
+}
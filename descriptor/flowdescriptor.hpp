@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FLOWDESCRIPTOR_HPP
+#define FLOWDESCRIPTOR_HPP
+
+#include <opencv2/core/core.hpp>
+#include <vector>
+#include <memory>
+
+#include "angledescriptor.hpp"
+#include "amplitudedescriptor.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk{
+    
+    /**
+     * Calculates angle and amplitude histograms in one pass over Cartesian
+     * flow. It is same as cartToPolar(), AmplitudeFactor::scale(),
+     * AngleDescriptor::normalizeAngles() and getHistogram() of both
+     * descriptors, but without intermediate Mats. Angle bins are found
+     * without atan2, see AngleDescriptor::calculateBin(dx, dy).
+     */
+    class FlowDescriptor {
+    private:
+        std::shared_ptr<AngleDescriptor> angleDescriptor;
+        std::shared_ptr<AmplitudeDescriptor> amplitudeDescriptor;
+        
+    public:
+        /**
+         * Any of descriptors can be NULL. Its histogram is then empty.
+         */
+        FlowDescriptor(std::shared_ptr<AngleDescriptor> angleDescriptor,
+                std::shared_ptr<AmplitudeDescriptor> amplitudeDescriptor);
+        
+        /**
+         * @param flow CV_32FC2 flow, usually cropped to ROI.
+         * @param amplitudeFactor Magnitudes are multiplied by this factor,
+         * same as AmplitudeFactor::scale().
+         */
+        void getHistograms(const Mat& flow, float amplitudeFactor,
+                vector<float>& angleHistogram, vector<float>& amplitudeHistogram) const;
+    };
+}
+
+#endif /* FLOWDESCRIPTOR_HPP */
+
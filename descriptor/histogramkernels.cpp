@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "histogramkernels.hpp"
+
+// Intrinsics in functions with target attribute need GCC 4.9 (AVX-512 GCC 5)
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || \
+    __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HISTOGRAM_SIMD
+#include <immintrin.h>
+#if defined(__clang__) || __GNUC__ >= 5
+#define HISTOGRAM_AVX512
+#endif
+#endif
+
+using namespace gk;
+
+namespace {
+    
+    const int LANES = HistogramKernels::LANES;
+    
+    struct AngleParams {
+        float minValue;
+        float binWidth;
+        int binCount;
+    };
+    
+    struct AmplitudeParams {
+        float scale;
+        float minAmplitude;
+        unsigned int binCount;
+    };
+    
+    typedef void (*AngleRow)(const float*, const float*, int, const AngleParams&, float*);
+    typedef void (*AmplitudeRow)(const float*, int, const AmplitudeParams&, float*);
+    
+    inline void angleStep(float angle, float magnitude, int lane, 
+            const AngleParams& p, float* sub) {
+        
+        int bin = cvFloor((angle - p.minValue)/p.binWidth);
+        if (bin > 0 && bin < p.binCount) {
+            sub[bin*LANES + lane] += magnitude;
+        }
+    }
+    
+    inline void amplitudeStep(float amplitude, int lane, 
+            const AmplitudeParams& p, float* sub) {
+        
+        /* Make sure amplitudes are positive values */
+        float pixValue = amplitude * amplitude;
+        pixValue = std::sqrt(pixValue) * p.scale;
+        
+        /* Skip everything below minAmplitude, do NOT saturate */
+        if (pixValue >= p.minAmplitude) {
+            /* Chop off the fractional part (rounding towards zero) */ 
+            unsigned int bin = (unsigned int)(pixValue - p.minAmplitude);
+            
+            /* Clip at top end, do NOT saturate */
+            if (bin < p.binCount) {
+                sub[bin*LANES + lane] += 1.0f;
+            }
+        }
+    }
+    
+    void angleRowScalar(const float* angles, const float* magnitudes, int cols,
+            const AngleParams& p, float* sub) {
+        
+        for (int x = 0; x < cols; x++) {
+            angleStep(angles[x], magnitudes[x], x % LANES, p, sub);
+        }
+    }
+    
+    void amplitudeRowScalar(const float* amplitudes, int cols,
+            const AmplitudeParams& p, float* sub) {
+        
+        for (int x = 0; x < cols; x++) {
+            amplitudeStep(amplitudes[x], x % LANES, p, sub);
+        }
+    }
+    
+#ifdef HISTOGRAM_SIMD
+    __attribute__((target("sse4.2")))
+    void angleRowSse42(const float* angles, const float* magnitudes, int cols,
+            const AngleParams& p, float* sub) {
+        
+        const __m128 minValue = _mm_set1_ps(p.minValue);
+        const __m128 binWidth = _mm_set1_ps(p.binWidth);
+        int bins[LANES];
+        
+        int x = 0;
+        for (; x + LANES <= cols; x += LANES) {
+            for (int h = 0; h < LANES; h += 4) {
+                __m128 v = _mm_loadu_ps(angles + x + h);
+                v = _mm_floor_ps(_mm_div_ps(_mm_sub_ps(v, minValue), binWidth));
+                _mm_storeu_si128((__m128i*) (bins + h), _mm_cvttps_epi32(v));
+            }
+            for (int l = 0; l < LANES; l++) {
+                if (bins[l] > 0 && bins[l] < p.binCount) {
+                    sub[bins[l]*LANES + l] += magnitudes[x + l];
+                }
+            }
+        }
+        for (; x < cols; x++) {
+            angleStep(angles[x], magnitudes[x], x % LANES, p, sub);
+        }
+    }
+    
+    __attribute__((target("sse4.2")))
+    void amplitudeRowSse42(const float* amplitudes, int cols,
+            const AmplitudeParams& p, float* sub) {
+        
+        const __m128 scale = _mm_set1_ps(p.scale);
+        const __m128 minAmplitude = _mm_set1_ps(p.minAmplitude);
+        int bins[LANES];
+        
+        int x = 0;
+        for (; x + LANES <= cols; x += LANES) {
+            int valid = 0;
+            for (int h = 0; h < LANES; h += 4) {
+                __m128 v = _mm_loadu_ps(amplitudes + x + h);
+                v = _mm_mul_ps(_mm_sqrt_ps(_mm_mul_ps(v, v)), scale);
+                valid |= _mm_movemask_ps(_mm_cmpge_ps(v, minAmplitude)) << h;
+                v = _mm_sub_ps(v, minAmplitude);
+                _mm_storeu_si128((__m128i*) (bins + h), _mm_cvttps_epi32(v));
+            }
+            for (int l = 0; l < LANES; l++) {
+                if (((valid >> l) & 1) && (unsigned int) bins[l] < p.binCount) {
+                    sub[bins[l]*LANES + l] += 1.0f;
+                }
+            }
+        }
+        for (; x < cols; x++) {
+            amplitudeStep(amplitudes[x], x % LANES, p, sub);
+        }
+    }
+    
+    __attribute__((target("avx2")))
+    void angleRowAvx2(const float* angles, const float* magnitudes, int cols,
+            const AngleParams& p, float* sub) {
+        
+        const __m256 minValue = _mm256_set1_ps(p.minValue);
+        const __m256 binWidth = _mm256_set1_ps(p.binWidth);
+        int bins[LANES];
+        
+        int x = 0;
+        for (; x + LANES <= cols; x += LANES) {
+            for (int h = 0; h < LANES; h += 8) {
+                __m256 v = _mm256_loadu_ps(angles + x + h);
+                v = _mm256_floor_ps(_mm256_div_ps(_mm256_sub_ps(v, minValue), binWidth));
+                _mm256_storeu_si256((__m256i*) (bins + h), _mm256_cvttps_epi32(v));
+            }
+            for (int l = 0; l < LANES; l++) {
+                if (bins[l] > 0 && bins[l] < p.binCount) {
+                    sub[bins[l]*LANES + l] += magnitudes[x + l];
+                }
+            }
+        }
+        for (; x < cols; x++) {
+            angleStep(angles[x], magnitudes[x], x % LANES, p, sub);
+        }
+    }
+    
+    __attribute__((target("avx2")))
+    void amplitudeRowAvx2(const float* amplitudes, int cols,
+            const AmplitudeParams& p, float* sub) {
+        
+        const __m256 scale = _mm256_set1_ps(p.scale);
+        const __m256 minAmplitude = _mm256_set1_ps(p.minAmplitude);
+        int bins[LANES];
+        
+        int x = 0;
+        for (; x + LANES <= cols; x += LANES) {
+            int valid = 0;
+            for (int h = 0; h < LANES; h += 8) {
+                __m256 v = _mm256_loadu_ps(amplitudes + x + h);
+                v = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_mul_ps(v, v)), scale);
+                valid |= _mm256_movemask_ps(_mm256_cmp_ps(v, minAmplitude, _CMP_GE_OQ)) << h;
+                v = _mm256_sub_ps(v, minAmplitude);
+                _mm256_storeu_si256((__m256i*) (bins + h), _mm256_cvttps_epi32(v));
+            }
+            for (int l = 0; l < LANES; l++) {
+                if (((valid >> l) & 1) && (unsigned int) bins[l] < p.binCount) {
+                    sub[bins[l]*LANES + l] += 1.0f;
+                }
+            }
+        }
+        for (; x < cols; x++) {
+            amplitudeStep(amplitudes[x], x % LANES, p, sub);
+        }
+    }
+#endif
+    
+#ifdef HISTOGRAM_AVX512
+    // Every lane has own sub-histogram, so gather/scatter never collide
+    __attribute__((target("avx512f")))
+    void angleRowAvx512(const float* angles, const float* magnitudes, int cols,
+            const AngleParams& p, float* sub) {
+        
+        const __m512 minValue = _mm512_set1_ps(p.minValue);
+        const __m512 binWidth = _mm512_set1_ps(p.binWidth);
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i binCount = _mm512_set1_epi32(p.binCount);
+        const __m512i lanes = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 
+                7, 6, 5, 4, 3, 2, 1, 0);
+        const __m512i laneCount = _mm512_set1_epi32(LANES);
+        
+        int x = 0;
+        for (; x + LANES <= cols; x += LANES) {
+            __m512 v = _mm512_loadu_ps(angles + x);
+            v = _mm512_roundscale_ps(_mm512_div_ps(_mm512_sub_ps(v, minValue), binWidth),
+                    _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+            __m512i bin = _mm512_cvttps_epi32(v);
+            __mmask16 valid = _mm512_cmpgt_epi32_mask(bin, zero) & 
+                    _mm512_cmplt_epi32_mask(bin, binCount);
+            __m512i index = _mm512_add_epi32(_mm512_mullo_epi32(bin, laneCount), lanes);
+            
+            __m512 h = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), valid, index, sub, 4);
+            h = _mm512_add_ps(h, _mm512_loadu_ps(magnitudes + x));
+            _mm512_mask_i32scatter_ps(sub, valid, index, h, 4);
+        }
+        for (; x < cols; x++) {
+            angleStep(angles[x], magnitudes[x], x % LANES, p, sub);
+        }
+    }
+    
+    __attribute__((target("avx512f")))
+    void amplitudeRowAvx512(const float* amplitudes, int cols,
+            const AmplitudeParams& p, float* sub) {
+        
+        const __m512 scale = _mm512_set1_ps(p.scale);
+        const __m512 minAmplitude = _mm512_set1_ps(p.minAmplitude);
+        const __m512 one = _mm512_set1_ps(1.0f);
+        const __m512i binCount = _mm512_set1_epi32((int) p.binCount);
+        const __m512i lanes = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 
+                7, 6, 5, 4, 3, 2, 1, 0);
+        const __m512i laneCount = _mm512_set1_epi32(LANES);
+        
+        int x = 0;
+        for (; x + LANES <= cols; x += LANES) {
+            __m512 v = _mm512_loadu_ps(amplitudes + x);
+            v = _mm512_mul_ps(_mm512_sqrt_ps(_mm512_mul_ps(v, v)), scale);
+            __mmask16 valid = _mm512_cmp_ps_mask(v, minAmplitude, _CMP_GE_OQ);
+            __m512i bin = _mm512_cvttps_epi32(_mm512_sub_ps(v, minAmplitude));
+            valid &= _mm512_cmplt_epu32_mask(bin, binCount);
+            __m512i index = _mm512_add_epi32(_mm512_mullo_epi32(bin, laneCount), lanes);
+            
+            __m512 h = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), valid, index, sub, 4);
+            h = _mm512_add_ps(h, one);
+            _mm512_mask_i32scatter_ps(sub, valid, index, h, 4);
+        }
+        for (; x < cols; x++) {
+            amplitudeStep(amplitudes[x], x % LANES, p, sub);
+        }
+    }
+#endif
+    
+    AngleRow getAngleRow(KernelIsa isa) {
+        switch (isa) {
+#ifdef HISTOGRAM_SIMD
+            case ISA_SSE42:
+                return angleRowSse42;
+            case ISA_AVX2:
+                return angleRowAvx2;
+#endif
+#ifdef HISTOGRAM_AVX512
+            case ISA_AVX512:
+                return angleRowAvx512;
+#endif
+            default:
+                return angleRowScalar;
+        }
+    }
+    
+    AmplitudeRow getAmplitudeRow(KernelIsa isa) {
+        switch (isa) {
+#ifdef HISTOGRAM_SIMD
+            case ISA_SSE42:
+                return amplitudeRowSse42;
+            case ISA_AVX2:
+                return amplitudeRowAvx2;
+#endif
+#ifdef HISTOGRAM_AVX512
+            case ISA_AVX512:
+                return amplitudeRowAvx512;
+#endif
+            default:
+                return amplitudeRowScalar;
+        }
+    }
+}
+
+KernelIsa HistogramKernels::isa = HistogramKernels::detectIsa();
+
+KernelIsa HistogramKernels::detectIsa() {
+    if (isSupported(ISA_AVX512)) {
+        return ISA_AVX512;
+    } else if (isSupported(ISA_AVX2)) {
+        return ISA_AVX2;
+    } else if (isSupported(ISA_SSE42)) {
+        return ISA_SSE42;
+    }
+    return ISA_SCALAR;
+}
+
+bool HistogramKernels::isSupported(KernelIsa isa) {
+    switch (isa) {
+        case ISA_AUTO:
+        case ISA_SCALAR:
+            return true;
+#ifdef HISTOGRAM_SIMD
+        case ISA_SSE42:
+            return __builtin_cpu_supports("sse4.2");
+        case ISA_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#ifdef HISTOGRAM_AVX512
+        case ISA_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+void HistogramKernels::setIsa(KernelIsa isa) {
+    if (!isSupported(isa)) {
+        string message = "Descriptor ISA " + getName(isa) + " is not supported.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    HistogramKernels::isa = isa == ISA_AUTO ? detectIsa() : isa;
+}
+
+KernelIsa HistogramKernels::getIsa() {
+    return isa;
+}
+
+KernelIsa HistogramKernels::fromName(const string& name) {
+    if (name == "auto") {
+        return ISA_AUTO;
+    } else if (name == "scalar") {
+        return ISA_SCALAR;
+    } else if (name == "sse4.2") {
+        return ISA_SSE42;
+    } else if (name == "avx2") {
+        return ISA_AVX2;
+    } else if (name == "avx512") {
+        return ISA_AVX512;
+    }
+    throw Exception(__FILE__, __LINE__, "Unknown descriptor ISA: " + name);
+}
+
+string HistogramKernels::getName(KernelIsa isa) {
+    switch (isa) {
+        case ISA_AUTO:
+            return "auto";
+        case ISA_SCALAR:
+            return "scalar";
+        case ISA_SSE42:
+            return "sse4.2";
+        case ISA_AVX2:
+            return "avx2";
+        case ISA_AVX512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+void HistogramKernels::merge(const vector<float>& subHistograms, vector<float>& histogram) {
+    for (size_t bin = 0; bin < histogram.size(); bin++) {
+        float sum = 0;
+        for (int l = 0; l < LANES; l++) {
+            sum += subHistograms[bin*LANES + l];
+        }
+        histogram[bin] = sum;
+    }
+}
+
+void HistogramKernels::angleHistogram(const Mat& angles, const Mat& magnitudes,
+        float minValue, float binWidth, int binCount, vector<float>& histogram) {
+    
+    histogram.assign(binCount, 0.f);
+    if (angles.empty()) {
+        return;
+    }
+    CV_Assert(angles.type() == CV_32FC1 && magnitudes.type() == CV_32FC1);
+    CV_Assert(angles.rows <= magnitudes.rows && angles.cols <= magnitudes.cols);
+    
+    AngleParams params = {minValue, binWidth, binCount};
+    AngleRow row = getAngleRow(isa);
+    
+    vector<float> subHistograms(binCount*LANES);
+    for (int y = 0; y < angles.rows; y++) {
+        row(angles.ptr<float>(y), magnitudes.ptr<float>(y), angles.cols, 
+                params, &subHistograms[0]);
+    }
+    merge(subHistograms, histogram);
+}
+
+void HistogramKernels::amplitudeHistogram(const Mat& amplitudes, float scale, 
+        float minAmplitude, int binCount, vector<float>& histogram) {
+    
+    histogram.assign(binCount, 0.f);
+    if (amplitudes.empty()) {
+        return;
+    }
+    CV_Assert(amplitudes.type() == CV_32FC1);
+    
+    AmplitudeParams params = {scale, minAmplitude, (unsigned int) binCount};
+    AmplitudeRow row = getAmplitudeRow(isa);
+    
+    vector<float> subHistograms(binCount*LANES);
+    for (int y = 0; y < amplitudes.rows; y++) {
+        row(amplitudes.ptr<float>(y), amplitudes.cols, params, &subHistograms[0]);
+    }
+    merge(subHistograms, histogram);
+}
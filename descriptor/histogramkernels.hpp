@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HISTOGRAMKERNELS_HPP
+#define HISTOGRAMKERNELS_HPP
+
+#include <opencv2/core/core.hpp>
+#include <vector>
+#include <string>
+
+#include "exception.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk{
+    
+    enum KernelIsa {
+        ISA_AUTO,
+        ISA_SCALAR,
+        ISA_SSE42,
+        ISA_AVX2,
+        ISA_AVX512
+    };
+    
+    /**
+     * Histogram loops of AngleDescriptor and AmplitudeDescriptor with 
+     * SSE4.2, AVX2 and AVX-512 implementations chosen at runtime.
+     * 
+     * Every column x is counted in sub-histogram x % LANES and 
+     * sub-histograms are merged in fixed order at the end. Scalar 
+     * implementation does the same, so histograms are bit-identical 
+     * across ISAs and scalar one can be used as reference.
+     * 
+     * Amplitude histograms are counts and equal to plain loop. Angle 
+     * histograms sum magnitudes in different order than plain loop, so 
+     * they differ from it by float rounding (relative error below 1e-6).
+     */
+    class HistogramKernels {
+    private:
+        static KernelIsa isa;
+        
+        HistogramKernels() {
+        }
+        
+        static KernelIsa detectIsa();
+        
+        static void merge(const vector<float>& subHistograms, vector<float>& histogram);
+        
+    public:
+        // AVX-512 register width in floats
+        static const int LANES = 16;
+        
+        /**
+         * Forces implementation. ISA_AUTO uses best supported one.
+         */
+        static void setIsa(KernelIsa isa);
+        
+        static KernelIsa getIsa();
+        
+        static bool isSupported(KernelIsa isa);
+        
+        static KernelIsa fromName(const string& name);
+        
+        static string getName(KernelIsa isa);
+        
+        /**
+         * Adds magnitudes to bin cvFloor((angle - minValue)/binWidth) 
+         * if bin is in (0, binCount).
+         */
+        static void angleHistogram(const Mat& angles, const Mat& magnitudes,
+                float minValue, float binWidth, int binCount, vector<float>& histogram);
+        
+        /**
+         * Counts |amplitude|*scale - minAmplitude, truncated to bin, if it 
+         * is not negative and bin is below binCount.
+         */
+        static void amplitudeHistogram(const Mat& amplitudes, float scale, 
+                float minAmplitude, int binCount, vector<float>& histogram);
+    };
+}
+
+#endif /* HISTOGRAMKERNELS_HPP */
+
@@ -21,6 +21,9 @@
 
 #include <string>
 #include <fstream>
+#include <memory>
+
+#include "lineindex.hpp"
 //#include "extrinsicfile.hpp"
 
 
@@ -35,11 +38,15 @@ namespace gk{
     protected:
         std::string filename;
         std::ifstream is;
+        // Built on first seek past line 1 if not given
+        std::shared_ptr<const LineIndex> lineIndex;
         
         std::ifstream& goToLine(std::ifstream& stream, const long startFrame);
         bool isGood();
     public:
         BaseFileReader(const std::string& filename);
+        BaseFileReader(const std::string& filename, 
+                const std::shared_ptr<const LineIndex>& lineIndex);
         ~BaseFileReader();
         virtual T getNext() = 0;
     };
@@ -51,6 +58,13 @@ namespace gk{
         is.open(filename);
     }
 
+    template<typename T>
+    BaseFileReader<T>::BaseFileReader(const std::string& filename,
+            const std::shared_ptr<const LineIndex>& lineIndex)
+    : filename(filename), lineIndex(lineIndex) {
+        is.open(filename);
+    }
+
     template<typename T>
     BaseFileReader<T>::~BaseFileReader() {
         if (is.is_open()) {
@@ -62,9 +76,19 @@ namespace gk{
     std::ifstream& BaseFileReader<T>::goToLine(std::ifstream& stream, const long startFrame) {
         // go to beginning
         stream.seekg(std::ios::beg);
-        std::string line;
-        for (long i = 0; i < startFrame - 1; i++) {
-            getline(stream, line);
+        if (startFrame <= 1 || !stream.is_open()) {
+            return stream;
+        }
+        
+        if (!lineIndex) {
+            lineIndex = LineIndex::get(filename);
+        }
+        int64_t offset = lineIndex->getOffset(startFrame);
+        if (offset < 0) {
+            // As if lines were read past end of file
+            stream.setstate(std::ios::eofbit | std::ios::failbit);
+        } else {
+            stream.seekg(offset);
         }
         return stream;
     }
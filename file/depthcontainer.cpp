@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "depthcontainer.hpp"
+
+using namespace gk;
+
+const char DepthContainer::MAGIC[8] = {'G', 'K', 'D', 'E', 'P', 'T', 'H', '1'};
+const string DepthContainer::EXTENSION = ".depth";
+
+bool DepthContainer::isContainer(const string& filename) {
+    return filename.size() > EXTENSION.size() &&
+            filename.compare(filename.size() - EXTENSION.size(), 
+            EXTENSION.size(), EXTENSION) == 0;
+}
+
+DepthContainer::DepthContainer(const string& filename)
+: filename(filename), fd(-1), mappedSize(0), mapped(NULL) {
+    
+    fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw Exception(__FILE__, __LINE__, "Could not open depth container " + filename);
+    }
+    
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (size_t) status.st_size < sizeof (Header)) {
+        ::close(fd);
+        throw Exception(__FILE__, __LINE__, "Depth container " + filename + " is too short.");
+    }
+    mappedSize = status.st_size;
+    
+    void* address = mmap(NULL, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        ::close(fd);
+        throw Exception(__FILE__, __LINE__, "Could not map depth container " + filename);
+    }
+    mapped = (const uint8_t*) address;
+    
+    std::memcpy(&header, mapped, sizeof (Header));
+    // Sizes are compared by division, so corrupt header can't overflow 
+    // them past check
+    size_t entrySize = sizeof (uint64_t) + sizeof (int64_t);
+    if (std::memcmp(header.magic, MAGIC, sizeof (MAGIC)) != 0 || header.frameCount < 0 ||
+            header.tableOffset < sizeof (Header) || header.tableOffset > mappedSize ||
+            (uint64_t) header.frameCount > (mappedSize - header.tableOffset) / entrySize ||
+            (uint64_t) header.width * header.height > mappedSize / sizeof (uint16_t)) {
+        munmap(address, mappedSize);
+        ::close(fd);
+        throw Exception(__FILE__, __LINE__, filename + " is not a depth container.");
+    }
+    offsets = (const uint64_t*) (mapped + header.tableOffset);
+    timeStamps = (const int64_t*) (mapped + header.tableOffset + 
+            header.frameCount * sizeof (uint64_t));
+}
+
+DepthContainer::~DepthContainer() {
+    munmap((void*) mapped, mappedSize);
+    ::close(fd);
+}
+
+bool DepthContainer::contains(const long frame) const {
+    long index = frame - header.firstFrame;
+    return index >= 0 && index < header.frameCount && offsets[index] != 0;
+}
+
+Mat DepthContainer::getFrame(const long frame) const {
+    if (!contains(frame)) {
+        throw Exception(__FILE__, __LINE__, 
+                "Frame " + std::to_string(frame) + " is not in " + filename);
+    }
+    
+    uint64_t offset = offsets[frame - header.firstFrame];
+    size_t frameSize = (size_t) header.width * header.height * sizeof (uint16_t);
+    if (offset > mappedSize || frameSize > mappedSize - offset) {
+        throw Exception(__FILE__, __LINE__, "Depth container " + filename + " is truncated.");
+    }
+    return Mat(header.height, header.width, CV_16UC1, (void*) (mapped + offset));
+}
+
+long DepthContainer::getTimeStamp(const long frame) const {
+    if (!contains(frame)) {
+        throw Exception(__FILE__, __LINE__, 
+                "Frame " + std::to_string(frame) + " is not in " + filename);
+    }
+    return timeStamps[frame - header.firstFrame];
+}
+
+long DepthContainer::getFirstFrame() const {
+    return header.firstFrame;
+}
+
+long DepthContainer::getFrameCount() const {
+    return header.frameCount;
+}
+
+Size DepthContainer::getFrameSize() const {
+    return Size(header.width, header.height);
+}
+
+
+
+DepthContainerWriter::DepthContainerWriter(const string& filename, 
+        const Size& frameSize, const long firstFrame) {
+    
+    std::memcpy(header.magic, DepthContainer::MAGIC, sizeof (header.magic));
+    header.width = frameSize.width;
+    header.height = frameSize.height;
+    header.firstFrame = firstFrame;
+    header.frameCount = 0;
+    header.tableOffset = 0;
+    
+    os.open(filename, ios::binary | ios::trunc);
+    if (!os.is_open()) {
+        throw Exception(__FILE__, __LINE__, "Could not open depth container " + filename);
+    }
+    // Rewritten on close()
+    os.write((const char*) &header, sizeof (DepthContainer::Header));
+}
+
+DepthContainerWriter::~DepthContainerWriter() {
+    if (os.is_open()) {
+        // Destructor may run while other exception unwinds
+        try {
+            close();
+        } catch (std::exception& e) {
+            cerr << e.what() << endl;
+        }
+    }
+}
+
+void DepthContainerWriter::write(const Mat& depth, const long timeStamp) {
+    if (depth.empty()) {
+        offsets.push_back(0);
+        timeStamps.push_back(timeStamp);
+        return;
+    }
+    if (depth.type() != CV_16UC1 || depth.cols != (int) header.width || 
+            depth.rows != (int) header.height) {
+        throw Exception(__FILE__, __LINE__, 
+                "Depth frame " + std::to_string(header.firstFrame + offsets.size()) + 
+                " must be 16-bit and of same size as first frame.");
+    }
+    
+    offsets.push_back((uint64_t) os.tellp());
+    timeStamps.push_back(timeStamp);
+    for (int r = 0; r < depth.rows; r++) {
+        os.write((const char*) depth.ptr<uint16_t>(r), depth.cols * sizeof (uint16_t));
+    }
+    if (!os.good()) {
+        throw Exception(__FILE__, __LINE__, "Could not write depth frame.");
+    }
+}
+
+void DepthContainerWriter::close() {
+    // Tables are aligned for reading them straight from mapping
+    uint64_t end = (uint64_t) os.tellp();
+    uint64_t padding = (sizeof (uint64_t) - end % sizeof (uint64_t)) % sizeof (uint64_t);
+    os.write("\0\0\0\0\0\0\0", padding);
+    
+    header.frameCount = offsets.size();
+    header.tableOffset = end + padding;
+    os.write((const char*) offsets.data(), offsets.size() * sizeof (uint64_t));
+    os.write((const char*) timeStamps.data(), timeStamps.size() * sizeof (int64_t));
+    
+    if (!os.good()) {
+        os.close();
+        throw Exception(__FILE__, __LINE__, "Could not write tables of depth container.");
+    }
+    
+    // Header of unfinished container has no tables, so readers reject it
+    os.seekp(0);
+    os.write((const char*) &header, sizeof (DepthContainer::Header));
+    os.flush();
+    bool written = os.good();
+    os.close();
+    if (!written || os.fail()) {
+        throw Exception(__FILE__, __LINE__, "Could not write header of depth container.");
+    }
+}
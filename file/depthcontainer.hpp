@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEPTHCONTAINER_HPP
+#define DEPTHCONTAINER_HPP
+
+#include <opencv2/core/core.hpp>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "exception.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Depth frames of one camera in one file. Header is followed by uint16
+     * frames in millimeters, same values as 16-bit PNG, and at the end by
+     * offset table and time stamp of every frame. Frames missing from 
+     * sequence have offset 0.
+     * 
+     * Reader maps file to memory. getFrame() returns Mat over mapping, so
+     * only pages read around metric center are loaded from disk.
+     */
+    class DepthContainer {
+    public:
+        struct Header {
+            char magic[8];
+            uint32_t width;
+            uint32_t height;
+            int64_t firstFrame;
+            int64_t frameCount;
+            // Offsets of frames are followed by time stamps
+            uint64_t tableOffset;
+        };
+        
+    private:
+        static const char MAGIC[8];
+
+        string filename;
+        int fd;
+        size_t mappedSize;
+        const uint8_t* mapped;
+        Header header;
+        const uint64_t* offsets;
+        const int64_t* timeStamps;
+        
+        friend class DepthContainerWriter;
+
+    public:
+        static const string EXTENSION;
+
+        static bool isContainer(const string& filename);
+
+        DepthContainer(const string& filename);
+
+        ~DepthContainer();
+
+        DepthContainer(const DepthContainer&) = delete;
+        DepthContainer& operator=(const DepthContainer&) = delete;
+
+        /**
+         * @param frame Frame number of sequence.
+         */
+        bool contains(const long frame) const;
+
+        /**
+         * @return Read only CV_16UC1 frame over mapping, valid while 
+         * container lives.
+         */
+        Mat getFrame(const long frame) const;
+
+        long getTimeStamp(const long frame) const;
+
+        long getFirstFrame() const;
+
+        long getFrameCount() const;
+
+        Size getFrameSize() const;
+    };
+
+    /**
+     * Appends frames in sequence order and writes tables on close().
+     */
+    class DepthContainerWriter {
+    private:
+        ofstream os;
+        DepthContainer::Header header;
+        vector<uint64_t> offsets;
+        vector<int64_t> timeStamps;
+
+    public:
+        DepthContainerWriter(const string& filename, const Size& frameSize,
+                const long firstFrame);
+
+        ~DepthContainerWriter();
+
+        /**
+         * Writes next frame of sequence. Empty depth marks missing frame.
+         */
+        void write(const Mat& depth, const long timeStamp);
+
+        /**
+         * Writes tables and header. Throws if they can't be written, e.g.
+         * when disk is full, and container is then rejected by readers.
+         */
+        void close();
+    };
+}
+
+#endif /* DEPTHCONTAINER_HPP */
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "framedecoder.hpp"
+
+using namespace gk;
+
+FrameDecoder::FrameDecoder(const string& filename, int depth,
+        const vector<bool>& neededFrames,
+        const long startFrame,
+        const bool gray)
+: capture(filename),
+depth(std::max(depth, 0)),
+gray(gray),
+neededFrames(neededFrames),
+grabbedCount(0),
+decodedCount(0),
+readCount(0),
+finished(false),
+stopping(false),
+positionMsec(0),
+positionFrames(0) {
+
+    fps = capture.get(CAP_PROP_FPS);
+    frameCount = capture.get(CAP_PROP_FRAME_COUNT);
+    fourcc = capture.get(CAP_PROP_FOURCC);
+    frameSize = Size((int) capture.get(CAP_PROP_FRAME_WIDTH),
+            (int) capture.get(CAP_PROP_FRAME_HEIGHT));
+
+    // Decoded frames ahead plus frames kept by consumer
+    slots.resize(this->depth + KEPT_FRAMES);
+    if (frameSize.area() > 0) {
+        for (Slot& slot : slots) {
+            slot.frame.create(frameSize, gray ? CV_8UC1 : CV_8UC3);
+        }
+    }
+
+    if (capture.isOpened() && startFrame > 0) {
+        seek(filename, startFrame);
+    }
+
+    if (capture.isOpened() && this->depth > 0) {
+        thread = std::thread(&FrameDecoder::run, this);
+    }
+}
+
+FrameDecoder::~FrameDecoder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    canDecode.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+bool FrameDecoder::decode(Slot& slot) {
+    slot.skipped = grabbedCount < (long) neededFrames.size() && 
+            !neededFrames[grabbedCount];
+    grabbedCount++;
+    
+    if (slot.skipped) {
+        // Skips color conversion and copy of retrieve()
+        if (!capture.grab()) {
+            return false;
+        }
+    } else if (gray) {
+        if (!capture.read(colorFrame)) {
+            return false;
+        }
+        if (colorFrame.channels() == 3) {
+            cvtColor(colorFrame, slot.frame, COLOR_BGR2GRAY);
+        } else {
+            colorFrame.copyTo(slot.frame);
+        }
+    } else if (!capture.read(slot.frame)) {
+        return false;
+    }
+    slot.positionMsec = capture.get(CAP_PROP_POS_MSEC);
+    slot.positionFrames = capture.get(CAP_PROP_POS_FRAMES);
+    return true;
+}
+
+void FrameDecoder::seek(const string& filename, const long frame) {
+    long position = 0;
+    
+    // Grabbing frames before first seek point after frame 0 is cheaper 
+    // than building index
+    if (frame >= KeyframeIndex::DEFAULT_INTERVAL) {
+        KeyframeIndex index = KeyframeIndex::get(filename);
+        long seekFrame = index.findSeekFrame(frame);
+        
+        if (seekFrame > 0) {
+            capture.set(CAP_PROP_POS_FRAMES, seekFrame);
+            
+            // Backend seeks by time stamps, which can be off. Then frames
+            // are grabbed from start.
+            double toleranceMsec = fps > 0 ? 500.0 / fps : 1.0;
+            if (capture.grab() && 
+                    index.isAt(seekFrame, capture.get(CAP_PROP_POS_MSEC), toleranceMsec)) {
+                position = seekFrame + 1;
+            } else {
+                cerr << "Seek to frame " << seekFrame << " missed, grabbing from start." << endl;
+                capture.open(filename);
+            }
+        }
+    }
+    
+    for (; position < frame; position++) {
+        if (!capture.grab()) {
+            break;
+        }
+    }
+    positionMsec = capture.get(CAP_PROP_POS_MSEC);
+    positionFrames = position;
+}
+
+void FrameDecoder::run() {
+    try {
+        for (;;) {
+            Slot* slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                canDecode.wait(lock, [this] {
+                    return stopping || decodedCount - readCount < depth;
+                });
+                if (stopping) {
+                    return;
+                }
+                // Consumer doesn't keep this slot any more
+                slot = &slots[decodedCount % slots.size()];
+            }
+
+            bool decoded = decode(*slot);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (decoded) {
+                    decodedCount++;
+                } else {
+                    finished = true;
+                }
+            }
+            canRead.notify_one();
+
+            if (!decoded) {
+                return;
+            }
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::current_exception();
+            finished = true;
+        }
+        canRead.notify_one();
+    }
+}
+
+bool FrameDecoder::isOpened() const {
+    return capture.isOpened();
+}
+
+bool FrameDecoder::read(Mat& frame) {
+    Slot* slot;
+    
+    if (depth == 0) {
+        // Slot of frame read two calls ago is free again
+        slot = &slots[readCount % slots.size()];
+        if (!decode(*slot)) {
+            return false;
+        }
+        readCount++;
+        
+    } else {
+        std::unique_lock<std::mutex> lock(mutex);
+        canRead.wait(lock, [this] {
+            return readCount < decodedCount || finished;
+        });
+        if (readCount == decodedCount) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return false;
+        }
+        slot = &slots[readCount % slots.size()];
+        readCount++;
+    }
+    
+    // Decoding thread doesn't write this slot until it is free
+    if (slot->skipped) {
+        frame = Mat();
+    } else {
+        frame = slot->frame;
+    }
+    positionMsec = slot->positionMsec;
+    positionFrames = slot->positionFrames;
+    
+    if (depth > 0) {
+        canDecode.notify_one();
+    }
+    return true;
+}
+
+double FrameDecoder::get(int propId) const {
+    switch (propId) {
+        case CAP_PROP_POS_MSEC:
+            return positionMsec;
+        case CAP_PROP_POS_FRAMES:
+            return positionFrames;
+        case CAP_PROP_FPS:
+            return fps;
+        case CAP_PROP_FRAME_COUNT:
+            return frameCount;
+        case CAP_PROP_FOURCC:
+            return fourcc;
+        case CAP_PROP_FRAME_WIDTH:
+            return frameSize.width;
+        case CAP_PROP_FRAME_HEIGHT:
+            return frameSize.height;
+        default:
+            throw Exception(__FILE__, __LINE__, 
+                    "Property " + std::to_string(propId) + " is not available from decoder.");
+    }
+}
+
+int FrameDecoder::getDepth() const {
+    return depth;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMEDECODER_HPP
+#define FRAMEDECODER_HPP
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "exception.hpp"
+#include "keyframeindex.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Owns VideoCapture and decodes up to depth frames ahead on own 
+     * thread into ring of preallocated Mats, so decoding overlaps with 
+     * flow calculation. With depth 0 frames are decoded in read().
+     * 
+     * read() returns header of ring slot without copying. Frame stays 
+     * valid until second next read(), so current and previous frame can
+     * be kept. Errors of decoding thread are rethrown by read() after 
+     * all frames decoded before error are read.
+     * 
+     * Decoding starts at startFrame, counted from 0. Seek uses cached 
+     * keyframe index and grab() to exact frame.
+     * 
+     * With gray, frames are converted to gray on decoding thread and ring
+     * keeps only gray frames, so consumer doesn't convert them and reads 
+     * third of memory.
+     * 
+     * Frames marked false in neededFrames are only grabbed, without 
+     * retrieving them, and read() returns them empty. Frames after end of
+     * neededFrames are needed.
+     * 
+     * read() and get() must not be called from more threads at once.
+     */
+    class FrameDecoder {
+    private:
+        // Frames that consumer may keep, current and previous
+        static const int KEPT_FRAMES = 2;
+
+        struct Slot {
+            Mat frame;
+            bool skipped;
+            double positionMsec;
+            double positionFrames;
+        };
+
+        VideoCapture capture;
+        int depth;
+        vector<Slot> slots;
+        bool gray;
+        // Color frame of decoder before gray conversion, used only by 
+        // decoding side
+        Mat colorFrame;
+        
+        // Indexed by frame number from startFrame, used only by decoding 
+        // side
+        vector<bool> neededFrames;
+        long grabbedCount;
+
+        // Guarded by mutex
+        long decodedCount;
+        long readCount;
+        bool finished;
+        bool stopping;
+        std::exception_ptr error;
+
+        std::mutex mutex;
+        std::condition_variable canDecode;
+        std::condition_variable canRead;
+        std::thread thread;
+
+        // Properties read before decoding started
+        double fps;
+        double frameCount;
+        double fourcc;
+        Size frameSize;
+
+        // Position after last read frame
+        double positionMsec;
+        double positionFrames;
+
+        bool decode(Slot& slot);
+        
+        void seek(const string& filename, const long frame);
+
+        void run();
+
+    public:
+        FrameDecoder(const string& filename, int depth, 
+                const vector<bool>& neededFrames = vector<bool>(),
+                const long startFrame = 0,
+                const bool gray = false);
+
+        ~FrameDecoder();
+
+        bool isOpened() const;
+
+        /**
+         * @return False at end of stream.
+         */
+        bool read(Mat& frame);
+
+        /**
+         * Same as VideoCapture::get() for positions, fps, frame count,
+         * codec and frame size. Positions are of last read frame.
+         */
+        double get(int propId) const;
+
+        int getDepth() const;
+    };
+}
+
+#endif /* FRAMEDECODER_HPP */
+
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "imageprefetcher.hpp"
+
+using namespace gk;
+
+ImagePrefetcher::ImagePrefetcher(const string& sequenceFilename, const long startFrame,
+        const int depth, const int threadCount, 
+        const vector<bool>& neededFrames, const int flags)
+: sequence(sequenceFilename, startFrame),
+depth(std::max(depth, 0)),
+flags(flags),
+neededFrames(neededFrames),
+firstFrame(std::max(startFrame, 1L)),
+stopping(false) {
+
+    lastFrame = findLastFrame();
+    nextFrame = firstFrame;
+    readFrame = firstFrame;
+    
+    if (this->depth > 0) {
+        slots.resize(this->depth);
+        for (Slot& slot : slots) {
+            slot.frame = -1;
+            slot.ready = false;
+        }
+        for (int i = 0; i < std::max(threadCount, 1); i++) {
+            threads.push_back(std::thread(&ImagePrefetcher::run, this));
+        }
+    }
+}
+
+ImagePrefetcher::~ImagePrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    canLoad.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+long ImagePrefetcher::findLastFrame() const {
+    // One directory scan instead of exists() for every frame
+    boost::filesystem::path first(sequence.formatFilename(firstFrame));
+    boost::filesystem::path directory = first.parent_path();
+    if (directory.empty()) {
+        directory = ".";
+    }
+    
+    unordered_set<string> names;
+    boost::system::error_code error;
+    for (boost::filesystem::directory_iterator it(directory, error), end; 
+            !error && it != end; it.increment(error)) {
+        names.insert(it->path().filename().string());
+    }
+    
+    long frame = firstFrame;
+    while (names.count(boost::filesystem::path(sequence.formatFilename(frame)).filename().string())) {
+        frame++;
+    }
+    return frame - 1;
+}
+
+Mat ImagePrefetcher::load(const long frame) const {
+    long index = frame - firstFrame;
+    if (index < (long) neededFrames.size() && !neededFrames[index]) {
+        return Mat();
+    }
+    
+    string name = sequence.formatFilename(frame);
+    Mat image = imread(name, flags);
+    if (image.empty()) {
+        throw Exception(__FILE__, __LINE__, "Could not read image " + name);
+    }
+    return image;
+}
+
+void ImagePrefetcher::run() {
+    for (;;) {
+        long frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            canLoad.wait(lock, [this] {
+                return stopping || 
+                        (nextFrame <= lastFrame && nextFrame < readFrame + depth);
+            });
+            if (stopping) {
+                return;
+            }
+            // Slot of frame - depth was already read
+            frame = nextFrame++;
+        }
+        
+        Mat image;
+        std::exception_ptr error;
+        try {
+            image = load(frame);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot& slot = slots[frame % depth];
+            slot.frame = frame;
+            slot.image = image;
+            slot.error = error;
+            slot.ready = true;
+        }
+        canRead.notify_one();
+    }
+}
+
+bool ImagePrefetcher::getNext(Mat& image) {
+    filename = sequence.formatFilename(readFrame);
+    if (readFrame > lastFrame) {
+        return false;
+    }
+    
+    if (depth == 0) {
+        // Failed frame is skipped, same as with threads
+        image = load(readFrame++);
+        return true;
+    }
+    
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        Slot& slot = slots[readFrame % depth];
+        canRead.wait(lock, [this, &slot] {
+            return slot.ready && slot.frame == readFrame;
+        });
+        image = slot.image;
+        error = slot.error;
+        slot.image = Mat();
+        slot.error = nullptr;
+        slot.ready = false;
+        readFrame++;
+    }
+    canLoad.notify_all();
+    
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return true;
+}
+
+const string& ImagePrefetcher::getFilename() const {
+    return filename;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IMAGEPREFETCHER_HPP
+#define IMAGEPREFETCHER_HPP
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include <boost/filesystem.hpp>
+
+#include "inputsequence.hpp"
+#include "exception.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Reads and decodes images of sequence up to depth frames ahead on 
+     * own threads, so consumer gets decoded image when it asks for it.
+     * With depth 0 images are read in getNext().
+     * 
+     * Directory is scanned once when prefetcher is made. Sequence ends 
+     * before first frame missing in that scan, same as InputSequence 
+     * ends on first missing file.
+     * 
+     * Frames marked false in neededFrames, counted from startFrame, are 
+     * not read and getNext() returns them empty. Frames after end of 
+     * neededFrames are needed.
+     * 
+     * Errors of reading threads are rethrown by getNext() of their frame.
+     * getNext() must not be called from more threads at once.
+     */
+    class ImagePrefetcher {
+    private:
+        struct Slot {
+            long frame;
+            bool ready;
+            Mat image;
+            std::exception_ptr error;
+        };
+
+        InputSequence sequence;
+        int depth;
+        int flags;
+        vector<bool> neededFrames;
+        long firstFrame;
+        // Last frame of sequence, firstFrame - 1 if sequence is empty
+        long lastFrame;
+        string filename;
+        vector<Slot> slots;
+
+        // Guarded by mutex
+        long nextFrame;
+        long readFrame;
+        bool stopping;
+
+        std::mutex mutex;
+        std::condition_variable canLoad;
+        std::condition_variable canRead;
+        vector<std::thread> threads;
+
+        long findLastFrame() const;
+
+        Mat load(const long frame) const;
+
+        void run();
+
+    public:
+        /**
+         * @param sequenceFilename Sequence path, as for InputSequence.
+         * @param flags Flags of imread().
+         */
+        ImagePrefetcher(const string& sequenceFilename, const long startFrame,
+                const int depth, const int threadCount, 
+                const vector<bool>& neededFrames = vector<bool>(),
+                const int flags = IMREAD_UNCHANGED);
+
+        ~ImagePrefetcher();
+
+        /**
+         * @return False after last frame of sequence.
+         */
+        bool getNext(Mat& image);
+
+        // Filename of last getNext()
+        const string& getFilename() const;
+    };
+}
+
+#endif /* IMAGEPREFETCHER_HPP */
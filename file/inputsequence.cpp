@@ -55,12 +55,7 @@ bool InputSequence::getFilename(string& filename){
     }
     
     // Build flo filename
-    if (sequenceFormat){
-        filename = boost::str(*sequenceFormat % frameNumber);   
-        
-    } else{
-        filename = basename;
-    }
+    filename = formatFilename(frameNumber);
     if(boost::filesystem::exists(filename)){
         return true;
         
@@ -69,6 +64,17 @@ bool InputSequence::getFilename(string& filename){
     }
 }
 
+string InputSequence::formatFilename(const long frameNumber) const{
+    if (sequenceFormat){
+        // Format keeps arguments, so copy is formatted
+        boost::format format(*sequenceFormat);
+        return boost::str(format % frameNumber);
+        
+    } else{
+        return basename;
+    }
+}
+
 bool InputSequence::getSequenceFormat(const string& filename, boost::format** sequenceFormat){    
     // If string contains format character
     string::size_type sequenceSpecifierPosition = filename.find('%');
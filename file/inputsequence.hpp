@@ -49,6 +49,8 @@ namespace gk{
         InputSequence(const string& basename, const long startFrame = 1, const string& fileType = ".png", const string& defaultSequenceFormat = "%04d");
         
         bool getFilename(string& filename);
+        // Filename of any frame, without checking that it exists
+        string formatFilename(const long frameNumber) const;
         bool sequenceEnabled() const;
         virtual int getFrameNumber() const;
     };
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keyframeindex.hpp"
+
+using namespace gk;
+
+KeyframeIndex::KeyframeIndex()
+: videoSize(0), videoTime(0), frameCount(0), interval(DEFAULT_INTERVAL) {
+
+}
+
+KeyframeIndex::KeyframeIndex(uintmax_t videoSize, std::time_t videoTime, long frameCount,
+        int interval, const vector<double>& positionsMsec)
+: videoSize(videoSize), videoTime(videoTime), frameCount(frameCount),
+interval(interval), positionsMsec(positionsMsec) {
+
+}
+
+KeyframeIndex KeyframeIndex::get(const string& videoFilename) {
+    string cacheFilename = getCacheFilename(videoFilename);
+    KeyframeIndex index;
+    if (read(cacheFilename, videoFilename, index)) {
+        return index;
+    }
+    
+    // Shards of same video start at once, so one process builds index 
+    // while others wait for it. Lock is released if process dies.
+    int lockFd = open(getLockFilename(videoFilename).c_str(), O_RDWR | O_CREAT, 0644);
+    if (lockFd >= 0 && flock(lockFd, LOCK_EX) != 0) {
+        ::close(lockFd);
+        lockFd = -1;
+    }
+    
+    try {
+        // Built by other process while this one waited
+        if (lockFd >= 0 && read(cacheFilename, videoFilename, index)) {
+            ::close(lockFd);
+            return index;
+        }
+        
+        cout << "Building keyframe index of " << videoFilename << "..." << endl;
+        index = build(videoFilename);
+        
+        // Shards of same video may read cache meanwhile, so it is written 
+        // to temporary file and renamed when complete
+        string tmpFilename = cacheFilename + 
+                boost::filesystem::unique_path(".%%%%-%%%%").string();
+        bool written;
+        {
+            KeyframeIndexFileWriter cacheFile(tmpFilename);
+            written = cacheFile.write(index);
+        }
+        boost::system::error_code error;
+        if (written) {
+            boost::filesystem::rename(tmpFilename, cacheFilename, error);
+        }
+        
+        // Index is still good for this run if cache can't be written
+        if (!written || error) {
+            boost::filesystem::remove(tmpFilename, error);
+            cerr << "Could not write keyframe index " << cacheFilename << endl;
+        }
+    } catch (...) {
+        if (lockFd >= 0) {
+            ::close(lockFd);
+        }
+        throw;
+    }
+    
+    if (lockFd >= 0) {
+        ::close(lockFd);
+    }
+    return index;
+}
+
+bool KeyframeIndex::read(const string& cacheFilename, const string& videoFilename,
+        KeyframeIndex& index) {
+    if (!boost::filesystem::exists(cacheFilename)) {
+        return false;
+    }
+    try {
+        KeyframeIndexFileReader cacheFile(cacheFilename);
+        index = cacheFile.getNext();
+        if (index.matches(videoFilename)) {
+            return true;
+        }
+    } catch (std::exception& e) {
+        cerr << e.what() << endl;
+    }
+    cout << "Keyframe index " << cacheFilename << " is stale." << endl;
+    return false;
+}
+
+KeyframeIndex KeyframeIndex::build(const string& videoFilename, const int interval) {
+    VideoCapture capture(videoFilename);
+    if (!capture.isOpened()) {
+        throw Exception(__FILE__, __LINE__, "Could not open video for keyframe index: " + videoFilename);
+    }
+
+    vector<double> positionsMsec;
+    long frame = 0;
+    for (; capture.grab(); frame++) {
+        if (frame % interval == 0) {
+            positionsMsec.push_back(capture.get(CAP_PROP_POS_MSEC));
+        }
+    }
+
+    return KeyframeIndex(boost::filesystem::file_size(videoFilename),
+            boost::filesystem::last_write_time(videoFilename),
+            frame, interval, positionsMsec);
+}
+
+string KeyframeIndex::getCacheFilename(const string& videoFilename) {
+    return videoFilename + ".keyframes";
+}
+
+string KeyframeIndex::getLockFilename(const string& videoFilename) {
+    return getCacheFilename(videoFilename) + ".lock";
+}
+
+bool KeyframeIndex::matches(const string& videoFilename) const {
+    return videoSize == boost::filesystem::file_size(videoFilename) &&
+            videoTime == boost::filesystem::last_write_time(videoFilename);
+}
+
+long KeyframeIndex::findSeekFrame(const long frame) const {
+    if (frame <= 0 || positionsMsec.empty()) {
+        return 0;
+    }
+    long point = std::min(frame / interval, (long) positionsMsec.size() - 1);
+    return point * interval;
+}
+
+bool KeyframeIndex::isAt(const long seekFrame, const double positionMsec,
+        const double toleranceMsec) const {
+    if (seekFrame % interval != 0 || seekFrame / interval >= (long) positionsMsec.size()) {
+        return false;
+    }
+    return std::abs(positionsMsec[seekFrame / interval] - positionMsec) <= toleranceMsec;
+}
+
+uintmax_t KeyframeIndex::getVideoSize() const {
+    return videoSize;
+}
+
+std::time_t KeyframeIndex::getVideoTime() const {
+    return videoTime;
+}
+
+long KeyframeIndex::getFrameCount() const {
+    return frameCount;
+}
+
+int KeyframeIndex::getInterval() const {
+    return interval;
+}
+
+const vector<double>& KeyframeIndex::getPositionsMsec() const {
+    return positionsMsec;
+}
+
+
+
+KeyframeIndexFileReader::KeyframeIndexFileReader(const string& filename)
+: BaseFileReader<KeyframeIndex>(filename) {
+
+}
+
+KeyframeIndex KeyframeIndexFileReader::getNext() {
+    if (!isGood()) {
+        throw Exception(__FILE__, __LINE__, "Could not open keyframe index " + filename);
+    }
+
+    string line;
+    char separator;
+    uintmax_t videoSize;
+    std::time_t videoTime;
+    long frameCount;
+    int interval;
+    if (!getline(is, line)) {
+        throw Exception(__FILE__, __LINE__, "Keyframe index " + filename + " is empty.");
+    }
+    istringstream header(line);
+    if (!(header >> videoSize >> separator >> videoTime >> separator
+            >> frameCount >> separator >> interval) || interval <= 0) {
+        throw Exception(__FILE__, __LINE__, "Bad header of keyframe index " + filename);
+    }
+
+    vector<double> positionsMsec;
+    double positionMsec;
+    while (is >> positionMsec) {
+        positionsMsec.push_back(positionMsec);
+    }
+
+    long pointCount = (frameCount + interval - 1) / interval;
+    if ((long) positionsMsec.size() != pointCount) {
+        throw Exception(__FILE__, __LINE__, "Keyframe index " + filename + " is incomplete.");
+    }
+    return KeyframeIndex(videoSize, videoTime, frameCount, interval, positionsMsec);
+}
+
+
+
+KeyframeIndexFileWriter::KeyframeIndexFileWriter(const string& filename)
+: BaseFileWriter<KeyframeIndex>(filename) {
+
+}
+
+bool KeyframeIndexFileWriter::write(const KeyframeIndex& index) {
+    if (os.good() && os.is_open()) {
+        os << index.getVideoSize() << ","
+                << index.getVideoTime() << ","
+                << index.getFrameCount() << ","
+                << index.getInterval() << endl;
+        
+        // Time stamps must survive round trip exactly
+        os.precision(17);
+        for (double positionMsec : index.getPositionsMsec()) {
+            os << positionMsec << endl;
+        }
+        return os.good();
+
+    } else {
+        return false;
+    }
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEYFRAMEINDEX_HPP
+#define KEYFRAMEINDEX_HPP
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <iostream>
+#include <ctime>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#include <boost/filesystem.hpp>
+
+#include "basefilereader.hpp"
+#include "basefilewriter.hpp"
+#include "exception.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Seek points of video. VideoCapture doesn't tell which frames are 
+     * keyframes, so time stamp of every interval-th frame is stored. 
+     * Backend seeks to keyframe before seek point and decodes forward to 
+     * it, and time stamp tells if it landed on right frame.
+     * 
+     * Index is built once with grab() over whole video and cached next 
+     * to video. Cache is rebuilt when size or time of video changes. 
+     * Processes building index of same video at once take turns on lock 
+     * file next to cache, so only first one decodes video.
+     * 
+     * Seeks before first seek point after frame 0 don't need index.
+     */
+    class KeyframeIndex {
+    private:
+        uintmax_t videoSize;
+        std::time_t videoTime;
+        long frameCount;
+        int interval;
+        // Milliseconds of frames 0, interval, 2 * interval, ...
+        vector<double> positionsMsec;
+
+        /**
+         * @return True if cache exists and matches video.
+         */
+        static bool read(const string& cacheFilename, const string& videoFilename,
+                KeyframeIndex& index);
+
+    public:
+        static const int DEFAULT_INTERVAL = 250;
+
+        KeyframeIndex();
+
+        KeyframeIndex(uintmax_t videoSize, std::time_t videoTime, long frameCount,
+                int interval, const vector<double>& positionsMsec);
+
+        /**
+         * Cached index if it matches video, else index built now and 
+         * cached.
+         */
+        static KeyframeIndex get(const string& videoFilename);
+
+        static KeyframeIndex build(const string& videoFilename,
+                const int interval = DEFAULT_INTERVAL);
+
+        static string getCacheFilename(const string& videoFilename);
+
+        static string getLockFilename(const string& videoFilename);
+
+        bool matches(const string& videoFilename) const;
+
+        /**
+         * @return Last seek point at or before frame. Frames count from 0.
+         */
+        long findSeekFrame(const long frame) const;
+
+        /**
+         * @return True if time stamp of grabbed frame is within tolerance 
+         * of seek point seekFrame.
+         */
+        bool isAt(const long seekFrame, const double positionMsec, 
+                const double toleranceMsec) const;
+
+        uintmax_t getVideoSize() const;
+        std::time_t getVideoTime() const;
+        long getFrameCount() const;
+        int getInterval() const;
+        const vector<double>& getPositionsMsec() const;
+    };
+
+    /**
+     * First line is size and modification time of video, frame count and
+     * interval. Every next line is time stamp in ms of next seek point.
+     */
+    class KeyframeIndexFileReader : public BaseFileReader<KeyframeIndex> {
+    public:
+        KeyframeIndexFileReader(const string& filename);
+
+        KeyframeIndex getNext() override;
+    };
+
+    class KeyframeIndexFileWriter : public BaseFileWriter<KeyframeIndex> {
+    public:
+        KeyframeIndexFileWriter(const string& filename);
+
+        bool write(const KeyframeIndex& index) override;
+    };
+}
+
+#endif /* KEYFRAMEINDEX_HPP */
+
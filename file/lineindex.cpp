@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lineindex.hpp"
+
+using namespace gk;
+
+const char LineIndex::MAGIC[8] = {'G', 'K', 'L', 'I', 'N', 'E', 'S', '1'};
+
+LineIndex::LineIndex(uintmax_t fileSize, std::time_t fileTime, const vector<uint64_t>& offsets)
+: fileSize(fileSize), fileTime(fileTime), offsets(offsets) {
+
+}
+
+std::shared_ptr<const LineIndex> LineIndex::get(const string& filename) {
+    string cacheFilename = getCacheFilename(filename);
+    if (boost::filesystem::exists(cacheFilename)) {
+        try {
+            std::shared_ptr<const LineIndex> index = read(cacheFilename);
+            if (index->matches(filename)) {
+                return index;
+            }
+        } catch (std::exception& e) {
+            cerr << e.what() << endl;
+        }
+        cout << "Line index " << cacheFilename << " is stale." << endl;
+    }
+
+    std::shared_ptr<const LineIndex> index = build(filename);
+    
+    // Index is still good for this run if cache can't be written
+    if (!index->write(cacheFilename)) {
+        cerr << "Could not write line index " << cacheFilename << endl;
+    }
+    return index;
+}
+
+std::shared_ptr<const LineIndex> LineIndex::build(const string& filename) {
+    // Size and time first, so file changed while indexing is indexed again
+    uintmax_t fileSize = boost::filesystem::file_size(filename);
+    std::time_t fileTime = boost::filesystem::last_write_time(filename);
+    
+    ifstream is(filename, ios::binary);
+    if (!is.is_open()) {
+        throw Exception(__FILE__, __LINE__, "Could not open file for line index: " + filename);
+    }
+
+    vector<uint64_t> offsets;
+    offsets.push_back(0);
+    
+    vector<char> buffer(1 << 16);
+    uint64_t position = 0;
+    while (is.read(buffer.data(), buffer.size()) || is.gcount() > 0) {
+        size_t count = is.gcount();
+        const char* begin = buffer.data();
+        const char* end = begin + count;
+        for (const char* p = begin; (p = (const char*) memchr(p, '\n', end - p)); p++) {
+            offsets.push_back(position + (p - begin) + 1);
+        }
+        position += count;
+    }
+
+    // Empty file has no lines
+    if (position == 0) {
+        offsets.clear();
+    }
+    return std::make_shared<LineIndex>(fileSize, fileTime, offsets);
+}
+
+std::shared_ptr<const LineIndex> LineIndex::read(const string& cacheFilename) {
+    ifstream is(cacheFilename, ios::binary);
+    Header header;
+    if (!is.read((char*) &header, sizeof (Header)) ||
+            memcmp(header.magic, MAGIC, sizeof (MAGIC)) != 0) {
+        throw Exception(__FILE__, __LINE__, "Bad header of line index " + cacheFilename);
+    }
+    // Corrupt count must not allocate offsets that aren't there
+    uintmax_t offsetsSize = boost::filesystem::file_size(cacheFilename) - sizeof (Header);
+    if (header.lineCount != offsetsSize / sizeof (uint64_t)) {
+        throw Exception(__FILE__, __LINE__, "Line index " + cacheFilename + " is incomplete.");
+    }
+
+    vector<uint64_t> offsets(header.lineCount);
+    if (!is.read((char*) offsets.data(), offsets.size() * sizeof (uint64_t))) {
+        throw Exception(__FILE__, __LINE__, "Line index " + cacheFilename + " is incomplete.");
+    }
+    return std::make_shared<LineIndex>(header.fileSize, header.fileTime, offsets);
+}
+
+bool LineIndex::write(const string& cacheFilename) const {
+    // Readers of other processes see old cache or whole new one
+    boost::filesystem::path tmpFilename = cacheFilename + 
+            boost::filesystem::unique_path(".%%%%-%%%%").string();
+    {
+        ofstream os(tmpFilename.string(), ios::binary);
+        Header header;
+        memcpy(header.magic, MAGIC, sizeof (MAGIC));
+        header.fileSize = fileSize;
+        header.fileTime = fileTime;
+        header.lineCount = offsets.size();
+        os.write((const char*) &header, sizeof (Header));
+        os.write((const char*) offsets.data(), offsets.size() * sizeof (uint64_t));
+        if (!os.good()) {
+            os.close();
+            boost::system::error_code error;
+            boost::filesystem::remove(tmpFilename, error);
+            return false;
+        }
+    }
+
+    boost::system::error_code error;
+    boost::filesystem::rename(tmpFilename, cacheFilename, error);
+    if (error) {
+        boost::filesystem::remove(tmpFilename, error);
+        return false;
+    }
+    return true;
+}
+
+string LineIndex::getCacheFilename(const string& filename) {
+    return filename + ".lines";
+}
+
+bool LineIndex::matches(const string& filename) const {
+    return fileSize == boost::filesystem::file_size(filename) &&
+            fileTime == boost::filesystem::last_write_time(filename);
+}
+
+int64_t LineIndex::getOffset(const long line) const {
+    if (line < 1 || line > (long) offsets.size()) {
+        return -1;
+    }
+    return offsets[line - 1];
+}
+
+long LineIndex::getLineCount() const {
+    return offsets.size();
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LINEINDEX_HPP
+#define LINEINDEX_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include <boost/filesystem.hpp>
+
+#include "exception.hpp"
+
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Offsets of line starts in text file, so reader can seek to start 
+     * frame instead of reading every line before it.
+     * 
+     * Index is built with one pass over file and cached next to it. Cache
+     * is rebuilt when size or time of file changes.
+     */
+    class LineIndex {
+    private:
+        uintmax_t fileSize;
+        std::time_t fileTime;
+        // Offset of line 1, 2, ... Last one is end of file if file ends 
+        // with new line.
+        vector<uint64_t> offsets;
+
+        static std::shared_ptr<const LineIndex> read(const string& cacheFilename);
+
+        bool write(const string& cacheFilename) const;
+
+    public:
+        struct Header {
+            char magic[8];
+            uint64_t fileSize;
+            int64_t fileTime;
+            uint64_t lineCount;
+        };
+
+        static const char MAGIC[8];
+
+        LineIndex(uintmax_t fileSize, std::time_t fileTime, const vector<uint64_t>& offsets);
+
+        /**
+         * Cached index if it matches file, else index built now and 
+         * cached.
+         */
+        static std::shared_ptr<const LineIndex> get(const string& filename);
+
+        static std::shared_ptr<const LineIndex> build(const string& filename);
+
+        static string getCacheFilename(const string& filename);
+
+        bool matches(const string& filename) const;
+
+        /**
+         * @return Offset of line, lines count from 1. -1 if file has no 
+         * such line.
+         */
+        int64_t getOffset(const long line) const;
+
+        long getLineCount() const;
+    };
+}
+
+#endif /* LINEINDEX_HPP */
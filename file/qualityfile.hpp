@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUALITYFILE_HPP
+#define QUALITYFILE_HPP
+
+#include <string>
+#include <iostream>
+#include <fstream>
+
+#include "basefilewriter.hpp"
+
+using namespace std;
+
+namespace gk{
+    
+    // Flow quality used for one written histogram
+    struct QualityRecord {
+        long timeStamp;
+        int level;
+        bool degraded;
+        int iterationsCount;
+        int pyramidLayers;
+        int windowSize;
+        // Milliseconds
+        double latency;
+    };
+        
+    /**
+     * Sidecar of histogram file. Every line belongs to histogram in same
+     * line and is: time stamp, quality level, degraded (0 or 1), 
+     * iterations, pyramid layers, window size and frame latency in ms.
+     */
+    class QualityFile : public BaseFileWriter<QualityRecord>{
+    public:
+        QualityFile(const string& filename);
+        
+        bool write(const QualityRecord& record) override;
+        
+    };
+}
+
+#endif /* QUALITYFILE_HPP */
+
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "selectionplanfile.hpp"
+
+using namespace gk;
+
+SelectionPlan::SelectionPlan(const long firstFrame)
+: firstFrame(firstFrame) {
+
+}
+
+void SelectionPlan::add(const int camera) {
+    selected.push_back(camera);
+}
+
+long SelectionPlan::getFirstFrame() const {
+    return firstFrame;
+}
+
+long SelectionPlan::getFrameCount() const {
+    return selected.size();
+}
+
+long SelectionPlan::getLastFrame() const {
+    return firstFrame + getFrameCount() - 1;
+}
+
+bool SelectionPlan::contains(const long frame) const {
+    return frame >= firstFrame && frame < firstFrame + getFrameCount();
+}
+
+int SelectionPlan::getSelected(const long frame) const {
+    if (!contains(frame)) {
+        throw Exception(__FILE__, __LINE__,
+                "Selection plan has no frame " + std::to_string(frame) + ".");
+    }
+    return selected[frame - firstFrame];
+}
+
+vector<bool> SelectionPlan::getNeededFrames(const int camera, const long startFrame) const {
+    long endFrame = firstFrame + getFrameCount();
+    vector<bool> needed(std::max(endFrame - startFrame, 0L), true);
+
+    for (long frame = std::max(startFrame, firstFrame - 1); frame < endFrame; frame++) {
+        bool current = contains(frame) && selected[frame - firstFrame] == camera;
+        bool next = contains(frame + 1) && selected[frame + 1 - firstFrame] == camera;
+        needed[frame - startFrame] = current || next;
+    }
+    return needed;
+}
+
+void SelectionPlan::getShard(const int shardCount, const int shardIndex,
+        long& firstFrame, long& lastFrame) const {
+    if (shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount) {
+        throw Exception(__FILE__, __LINE__, "Shard index must be from 0 to shard count - 1.");
+    }
+    // First frameCount % shardCount shards get one frame more
+    long size = getFrameCount() / shardCount;
+    long remainder = getFrameCount() % shardCount;
+
+    firstFrame = this->firstFrame + shardIndex * size + std::min((long) shardIndex, remainder);
+    lastFrame = firstFrame + size - 1;
+    if (shardIndex < remainder) {
+        lastFrame++;
+    }
+}
+
+
+SelectionPlanFileReader::SelectionPlanFileReader(const string& filename)
+: BaseFileReader<SelectionPlan>(filename) {
+
+}
+
+SelectionPlan SelectionPlanFileReader::getNext() {
+    if (!isGood()) {
+        throw Exception(__FILE__, __LINE__, "Could not open selection plan " + filename);
+    }
+
+    // Header
+    string line;
+    char separator;
+    long firstFrame, frameCount;
+    if (!getline(is, line)) {
+        throw Exception(__FILE__, __LINE__, "Selection plan " + filename + " is empty.");
+    }
+    istringstream header(line);
+    if (!(header >> firstFrame >> separator >> frameCount) || frameCount < 0) {
+        throw Exception(__FILE__, __LINE__, "Bad header of selection plan " + filename);
+    }
+
+    // Camera switches
+    SelectionPlan plan(firstFrame);
+    long frame = firstFrame, nextFrame;
+    int camera = 0, nextCamera;
+    bool hasSwitch = false;
+    while (getline(is, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        istringstream lineStream(line);
+        if (!(lineStream >> nextFrame >> separator >> nextCamera)) {
+            throw Exception(__FILE__, __LINE__, "Bad line in selection plan " + filename + ": " + line);
+        }
+        if (hasSwitch) {
+            for (; frame < nextFrame; frame++) {
+                plan.add(camera);
+            }
+        } else if (nextFrame != firstFrame) {
+            throw Exception(__FILE__, __LINE__, "Selection plan " + filename + " doesn't start with first frame.");
+        }
+        frame = nextFrame;
+        camera = nextCamera;
+        hasSwitch = true;
+    }
+    if (hasSwitch) {
+        for (; frame < firstFrame + frameCount; frame++) {
+            plan.add(camera);
+        }
+    }
+
+    if (plan.getFrameCount() != frameCount) {
+        throw Exception(__FILE__, __LINE__, "Frame count of selection plan " + filename + " doesn't match its switches.");
+    }
+    return plan;
+}
+
+
+
+SelectionPlanFileWriter::SelectionPlanFileWriter(const string& filename)
+: BaseFileWriter<SelectionPlan>(filename) {
+
+}
+
+bool SelectionPlanFileWriter::write(const SelectionPlan& plan) {
+    if (os.good() && os.is_open()) {
+        os << plan.getFirstFrame() << "," << plan.getFrameCount() << endl;
+
+        int previous = -1;
+        long lastFrame = plan.getFirstFrame() + plan.getFrameCount();
+        for (long frame = plan.getFirstFrame(); frame < lastFrame; frame++) {
+            int camera = plan.getSelected(frame);
+            if (camera != previous) {
+                os << frame << "," << camera << endl;
+                previous = camera;
+            }
+        }
+        return true;
+
+    } else {
+        return false;
+    }
+}
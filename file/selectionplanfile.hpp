@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SELECTIONPLANFILE_HPP
+#define SELECTIONPLANFILE_HPP
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <iostream>
+
+#include "basefilereader.hpp"
+#include "basefilewriter.hpp"
+#include "exception.hpp"
+
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Selected camera for every frame of recording, precomputed from 
+     * tracker boxes and depth images. Frames are numbered as in image 
+     * sequences and tracker files.
+     */
+    class SelectionPlan {
+    private:
+        long firstFrame;
+        vector<int> selected;
+
+    public:
+        SelectionPlan(const long firstFrame = 1);
+
+        void add(const int camera);
+
+        long getFirstFrame() const;
+
+        long getFrameCount() const;
+
+        /**
+         * @return Last frame of plan, firstFrame - 1 if plan is empty.
+         */
+        long getLastFrame() const;
+
+        bool contains(const long frame) const;
+
+        /**
+         * @return Camera selected for frame. Throws if plan doesn't 
+         * contain frame.
+         */
+        int getSelected(const long frame) const;
+
+        /**
+         * Frames from startFrame on that camera decodes. Frame is needed 
+         * if camera is selected for it or for next frame, which takes it 
+         * as previous frame. Frames outside plan are needed.
+         * 
+         * @return One item for every frame until end of plan.
+         */
+        vector<bool> getNeededFrames(const int camera, const long startFrame) const;
+
+        /**
+         * Frames of plan split to shardCount chunks of nearly same size.
+         * Chunk of shardIndex is from firstFrame to lastFrame, inclusive.
+         */
+        void getShard(const int shardCount, const int shardIndex,
+                long& firstFrame, long& lastFrame) const;
+    };
+
+    /**
+     * First line is first frame and frame count. Every next line is frame
+     * and camera selected from this frame on, so only camera switches are
+     * stored.
+     */
+    class SelectionPlanFileReader : public BaseFileReader<SelectionPlan> {
+    public:
+        SelectionPlanFileReader(const string& filename);
+
+        SelectionPlan getNext() override;
+    };
+
+    class SelectionPlanFileWriter : public BaseFileWriter<SelectionPlan> {
+    public:
+        SelectionPlanFileWriter(const string& filename);
+
+        bool write(const SelectionPlan& plan) override;
+    };
+}
+
+#endif /* SELECTIONPLANFILE_HPP */
+
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shardfiles.hpp"
+
+using namespace gk;
+
+string ShardFiles::getFilename(const string& filename, const int shardIndex) {
+    return filename + ".shard" + std::to_string(shardIndex);
+}
+
+void ShardFiles::merge(const string& filename, const int shardCount) {
+    std::ofstream os(filename, std::ios::binary);
+    if (!os.is_open()) {
+        throw Exception(__FILE__, __LINE__, "Could not open " + filename);
+    }
+
+    for (int i = 0; i < shardCount; i++) {
+        string shardFilename = getFilename(filename, i);
+        std::ifstream is(shardFilename, std::ios::binary);
+        if (!is.is_open()) {
+            throw Exception(__FILE__, __LINE__, "Missing shard file " + shardFilename);
+        }
+        // Empty shard has nothing to copy
+        if (is.peek() != std::ifstream::traits_type::eof()) {
+            os << is.rdbuf();
+        }
+    }
+
+    if (!os.good()) {
+        throw Exception(__FILE__, __LINE__, "Could not write " + filename);
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHARDFILES_HPP
+#define SHARDFILES_HPP
+
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include "exception.hpp"
+
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Static utility class for output files of recording split to shards.
+     * Shard k writes to filename.shard<k> and merge concatenates shard 
+     * files in order of shards.
+     */
+    class ShardFiles {
+    private:
+        // Don't instantiate this class
+
+        ShardFiles() {
+        }
+
+    public:
+        static string getFilename(const string& filename, const int shardIndex);
+
+        /**
+         * Writes filename from shardCount shard files. Throws if a shard
+         * file is missing.
+         */
+        static void merge(const string& filename, const int shardCount);
+    };
+}
+
+#endif /* SHARDFILES_HPP */
+
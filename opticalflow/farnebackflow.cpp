@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "farnebackflow.hpp"
+
+using namespace gk;
+
+FarnebackFlow::FarnebackFlow(double pyramidScale, int pyramidLayers, int windowSize,
+        int iterationsCount, int neighbourSize, double gaussianDeviation,
+        int operationFlags)
+: pyramidScale(pyramidScale), pyramidLayers(pyramidLayers),
+windowSize(windowSize), iterationsCount(iterationsCount),
+neighbourSize(neighbourSize), gaussianDeviation(gaussianDeviation),
+operationFlags(operationFlags) {
+
+    if (pyramidScale <= 0 || pyramidScale >= 1) {
+        throw Exception(__FILE__, __LINE__, "Pyramid scale must be in (0, 1).");
+    }
+    if (neighbourSize < 1 || windowSize < 1) {
+        throw Exception(__FILE__, __LINE__, "Neighbour and window size must be positive.");
+    }
+
+    prepareGaussian();
+}
+
+void FarnebackFlow::prepareGaussian() {
+    int n = neighbourSize;
+    double sigma = gaussianDeviation;
+    if (sigma < FLT_EPSILON) {
+        sigma = n * 0.3;
+    }
+
+    vector<double> kernel(2 * n + 1);
+    double s = 0;
+    for (int x = -n; x <= n; x++) {
+        kernel[x + n] = std::exp(-x * x / (2 * sigma * sigma));
+        s += kernel[x + n];
+    }
+
+    g.resize(n + 1);
+    xg.resize(n + 1);
+    xxg.resize(n + 1);
+    for (int x = 0; x <= n; x++) {
+        g[x] = (float) (kernel[x + n] / s);
+        xg[x] = (float) (x * g[x]);
+        xxg[x] = (float) (x * x * g[x]);
+    }
+
+    // Same normal matrix as in calcOpticalFlowFarneback()
+    Mat_<double> G = Mat_<double>::zeros(6, 6);
+    for (int y = -n; y <= n; y++) {
+        for (int x = -n; x <= n; x++) {
+            double gyx = g[std::abs(y)] * g[std::abs(x)];
+            G(0, 0) += gyx;
+            G(1, 1) += gyx * x * x;
+            G(3, 3) += gyx * x * x * x * x;
+            G(5, 5) += gyx * x * x * y * y;
+        }
+    }
+    G(2, 2) = G(0, 3) = G(0, 4) = G(3, 0) = G(4, 0) = G(1, 1);
+    G(4, 4) = G(3, 3);
+    G(3, 4) = G(4, 3) = G(5, 5);
+
+    Mat_<double> invG = G.inv(DECOMP_CHOLESKY);
+    ig11 = (float) invG(1, 1);
+    ig03 = (float) invG(0, 3);
+    ig33 = (float) invG(3, 3);
+    ig55 = (float) invG(5, 5);
+}
+
+void FarnebackFlow::calc(const Mat& prevGray, const Mat& gray, Mat& flow) {
+    if (prevGray.size() != gray.size()) {
+        throw Exception(__FILE__, __LINE__, "Frames for flow have different sizes.");
+    }
+
+    // Expansion of previous frame is usually expansion of last frame
+    if (isCached(prevGray)) {
+        std::swap(prevLayers, layers);
+    } else {
+        expand(prevGray, prevLayers);
+    }
+    expand(gray, layers);
+    gray.copyTo(cachedGray);
+
+    Mat prevFlow;
+    for (int k = (int) layers.size() - 1; k >= 0; k--) {
+        Size size = layers[k].r[0].size();
+        Mat levelFlow;
+
+        if (!prevFlow.empty()) {
+            resize(prevFlow, levelFlow, size, 0, 0, INTER_LINEAR);
+            levelFlow *= 1. / pyramidScale;
+
+        } else if ((operationFlags & OPTFLOW_USE_INITIAL_FLOW) &&
+                flow.size() == gray.size() && flow.type() == CV_32FC2) {
+            resize(flow, levelFlow, size, 0, 0, INTER_AREA);
+            levelFlow *= layers[k].scale;
+
+        } else {
+            levelFlow = Mat::zeros(size, CV_32FC2);
+        }
+
+        updateMatrices(prevLayers[k], layers[k], levelFlow);
+        for (int i = 0; i < iterationsCount; i++) {
+            updateFlow(levelFlow);
+            if (i < iterationsCount - 1) {
+                updateMatrices(prevLayers[k], layers[k], levelFlow);
+            }
+        }
+
+        prevFlow = levelFlow;
+    }
+
+    flow = prevFlow;
+}
+
+void FarnebackFlow::reset() {
+    cachedGray.release();
+    prevLayers.clear();
+    layers.clear();
+}
+
+bool FarnebackFlow::isCached(const Mat& gray) const {
+    if (cachedGray.empty() || layers.empty() ||
+            cachedGray.size() != gray.size() || cachedGray.type() != gray.type()) {
+        return false;
+    }
+    return norm(gray, cachedGray, NORM_INF) == 0;
+}
+
+void FarnebackFlow::expand(const Mat& gray, vector<PolyLayer>& layers) const {
+    if (gray.channels() != 1) {
+        throw Exception(__FILE__, __LINE__, "Farneback needs gray frame.");
+    }
+
+    // Truncate layers like calcOpticalFlowFarneback()
+    int levelCount = 0;
+    double scale = 1;
+    for (; levelCount < pyramidLayers; levelCount++) {
+        scale *= pyramidScale;
+        if (gray.cols * scale < MIN_SIZE || gray.rows * scale < MIN_SIZE) {
+            break;
+        }
+    }
+    layers.resize(levelCount + 1);
+
+    Mat fimg, smoothed, level;
+    gray.convertTo(fimg, CV_32F);
+
+    scale = 1;
+    for (int k = 0; k <= levelCount; k++) {
+        double sigma = (1. / scale - 1) * 0.5;
+        int smoothSize = cvRound(sigma * 5) | 1;
+        smoothSize = std::max(smoothSize, 3);
+
+        Size size(cvRound(gray.cols * scale), cvRound(gray.rows * scale));
+
+        GaussianBlur(fimg, smoothed, Size(smoothSize, smoothSize), sigma, sigma);
+        resize(smoothed, level, size, 0, 0, INTER_LINEAR);
+
+        layers[k].scale = scale;
+        polyExp(level, layers[k]);
+
+        scale *= pyramidScale;
+    }
+}
+
+void FarnebackFlow::polyExp(const Mat& src, PolyLayer& layer) const {
+    int n = neighbourSize;
+    int width = src.cols;
+    int height = src.rows;
+    int stride = width + 2 * n;
+
+    for (int c = 0; c < 5; c++) {
+        layer.r[c].create(height, width, CV_32FC1);
+    }
+
+    // Vertical sums with replicated border and horizontal accumulators
+    vector<float> buffer(stride * 3 + width * 6);
+    float* v0 = &buffer[n];
+    float* v1 = v0 + stride;
+    float* v2 = v1 + stride;
+    float* b1 = &buffer[stride * 3];
+    float* b2 = b1 + width;
+    float* b3 = b2 + width;
+    float* b4 = b3 + width;
+    float* b5 = b4 + width;
+    float* b6 = b5 + width;
+
+    for (int y = 0; y < height; y++) {
+        const float* srow = src.ptr<float>(y);
+
+        // Vertical part: 1, y and y^2 moments
+        for (int x = 0; x < width; x++) {
+            v0[x] = srow[x] * g[0];
+            v1[x] = 0.f;
+            v2[x] = 0.f;
+        }
+        for (int k = 1; k <= n; k++) {
+            const float* srow0 = src.ptr<float>(std::max(y - k, 0));
+            const float* srow1 = src.ptr<float>(std::min(y + k, height - 1));
+            float gk = g[k], xgk = xg[k], xxgk = xxg[k];
+
+            for (int x = 0; x < width; x++) {
+                float p = srow0[x] + srow1[x];
+                v0[x] += gk * p;
+                v1[x] += xgk * (srow1[x] - srow0[x]);
+                v2[x] += xxgk * p;
+            }
+        }
+
+        for (int k = 1; k <= n; k++) {
+            v0[-k] = v0[0];
+            v1[-k] = v1[0];
+            v2[-k] = v2[0];
+            v0[width - 1 + k] = v0[width - 1];
+            v1[width - 1 + k] = v1[width - 1];
+            v2[width - 1 + k] = v2[width - 1];
+        }
+
+        // Horizontal part
+        for (int x = 0; x < width; x++) {
+            b1[x] = v0[x] * g[0];
+            b2[x] = 0.f;
+            b3[x] = v1[x] * g[0];
+            b4[x] = 0.f;
+            b5[x] = v2[x] * g[0];
+            b6[x] = 0.f;
+        }
+        for (int k = 1; k <= n; k++) {
+            const float *l0 = v0 - k, *r0 = v0 + k;
+            const float *l1 = v1 - k, *r1 = v1 + k;
+            const float *l2 = v2 - k, *r2 = v2 + k;
+            float gk = g[k], xgk = xg[k], xxgk = xxg[k];
+
+            for (int x = 0; x < width; x++) {
+                float t = r0[x] + l0[x];
+                b1[x] += t * gk;
+                b4[x] += t * xxgk;
+                b2[x] += (r0[x] - l0[x]) * xgk;
+                b3[x] += (r1[x] + l1[x]) * gk;
+                b6[x] += (r1[x] - l1[x]) * xgk;
+                b5[x] += (r2[x] + l2[x]) * gk;
+            }
+        }
+
+        // Same coefficient order as calcOpticalFlowFarneback(), r1 is not stored
+        float* d0 = layer.r[0].ptr<float>(y);
+        float* d1 = layer.r[1].ptr<float>(y);
+        float* d2 = layer.r[2].ptr<float>(y);
+        float* d3 = layer.r[3].ptr<float>(y);
+        float* d4 = layer.r[4].ptr<float>(y);
+        for (int x = 0; x < width; x++) {
+            d0[x] = b3[x] * ig11;
+            d1[x] = b2[x] * ig11;
+            d2[x] = b1[x] * ig03 + b5[x] * ig33;
+            d3[x] = b1[x] * ig03 + b4[x] * ig33;
+            d4[x] = b6[x] * ig55;
+        }
+    }
+}
+
+void FarnebackFlow::updateMatrices(const PolyLayer& r0, const PolyLayer& r1, const Mat& flow) {
+    static const float border[BORDER] = {0.14f, 0.14f, 0.4472f, 0.4472f, 0.4472f};
+
+    int width = flow.cols;
+    int height = flow.rows;
+
+    for (int c = 0; c < 5; c++) {
+        m[c].create(height, width, CV_32FC1);
+    }
+
+    for (int y = 0; y < height; y++) {
+        const float* f = flow.ptr<float>(y);
+        const float* a0 = r0.r[0].ptr<float>(y);
+        const float* a1 = r0.r[1].ptr<float>(y);
+        const float* a2 = r0.r[2].ptr<float>(y);
+        const float* a3 = r0.r[3].ptr<float>(y);
+        const float* a4 = r0.r[4].ptr<float>(y);
+        float* m0 = m[0].ptr<float>(y);
+        float* m1 = m[1].ptr<float>(y);
+        float* m2 = m[2].ptr<float>(y);
+        float* m3 = m[3].ptr<float>(y);
+        float* m4 = m[4].ptr<float>(y);
+
+        for (int x = 0; x < width; x++) {
+            float dx = f[x * 2], dy = f[x * 2 + 1];
+            float fx = x + dx, fy = y + dy;
+            int x1 = cvFloor(fx), y1 = cvFloor(fy);
+            float rr2, rr3, rr4, rr5, rr6;
+
+            fx -= x1;
+            fy -= y1;
+
+            if ((unsigned) x1 < (unsigned) (width - 1) &&
+                    (unsigned) y1 < (unsigned) (height - 1)) {
+                float a00 = (1.f - fx)*(1.f - fy), a01 = fx * (1.f - fy),
+                        a10 = (1.f - fx) * fy, a11 = fx * fy;
+                float b[5];
+                for (int c = 0; c < 5; c++) {
+                    const float* p0 = r1.r[c].ptr<float>(y1) + x1;
+                    const float* p1 = r1.r[c].ptr<float>(y1 + 1) + x1;
+                    b[c] = a00 * p0[0] + a01 * p0[1] + a10 * p1[0] + a11 * p1[1];
+                }
+                rr2 = b[0];
+                rr3 = b[1];
+                rr4 = (a2[x] + b[2]) * 0.5f;
+                rr5 = (a3[x] + b[3]) * 0.5f;
+                rr6 = (a4[x] + b[4]) * 0.25f;
+
+            } else {
+                rr2 = rr3 = 0.f;
+                rr4 = a2[x];
+                rr5 = a3[x];
+                rr6 = a4[x] * 0.5f;
+            }
+
+            rr2 = (a0[x] - rr2) * 0.5f;
+            rr3 = (a1[x] - rr3) * 0.5f;
+
+            rr2 += rr4 * dy + rr6 * dx;
+            rr3 += rr6 * dy + rr5 * dx;
+
+            if ((unsigned) (x - BORDER) >= (unsigned) (width - BORDER * 2) ||
+                    (unsigned) (y - BORDER) >= (unsigned) (height - BORDER * 2)) {
+                float scale = (x < BORDER ? border[x] : 1.f)*
+                        (x >= width - BORDER ? border[width - x - 1] : 1.f)*
+                        (y < BORDER ? border[y] : 1.f)*
+                        (y >= height - BORDER ? border[height - y - 1] : 1.f);
+
+                rr2 *= scale;
+                rr3 *= scale;
+                rr4 *= scale;
+                rr5 *= scale;
+                rr6 *= scale;
+            }
+
+            m0[x] = rr4 * rr4 + rr6 * rr6;
+            m1[x] = (rr4 + rr5) * rr6;
+            m2[x] = rr5 * rr5 + rr6 * rr6;
+            m3[x] = rr4 * rr2 + rr6 * rr3;
+            m4[x] = rr6 * rr2 + rr5 * rr3;
+        }
+    }
+}
+
+void FarnebackFlow::updateFlow(Mat& flow) {
+    // Window is 2*(windowSize/2)+1 like in calcOpticalFlowFarneback()
+    int half = windowSize / 2;
+    Size window(half * 2 + 1, half * 2 + 1);
+    double scale;
+
+    if (operationFlags & OPTFLOW_FARNEBACK_GAUSSIAN) {
+        double sigma = half * 0.3;
+        for (int c = 0; c < 5; c++) {
+            GaussianBlur(m[c], blurred[c], window, sigma, sigma, BORDER_REPLICATE);
+        }
+        scale = 1;
+
+    } else {
+        for (int c = 0; c < 5; c++) {
+            boxFilter(m[c], blurred[c], -1, window, Point(-1, -1), false, BORDER_REPLICATE);
+        }
+        scale = 1. / window.area();
+    }
+
+    for (int y = 0; y < flow.rows; y++) {
+        const float* g11 = blurred[0].ptr<float>(y);
+        const float* g12 = blurred[1].ptr<float>(y);
+        const float* g22 = blurred[2].ptr<float>(y);
+        const float* h1 = blurred[3].ptr<float>(y);
+        const float* h2 = blurred[4].ptr<float>(y);
+        float* f = flow.ptr<float>(y);
+
+        for (int x = 0; x < flow.cols; x++) {
+            double a11 = g11[x] * scale, a12 = g12[x] * scale, a22 = g22[x] * scale;
+            double c1 = h1[x] * scale, c2 = h2[x] * scale;
+            double idet = 1. / (a11 * a22 - a12 * a12 + 1e-3);
+
+            f[x * 2] = (float) ((a11 * c2 - a12 * c1) * idet);
+            f[x * 2 + 1] = (float) ((a22 * c1 - a12 * c2) * idet);
+        }
+    }
+}
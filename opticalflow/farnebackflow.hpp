@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FARNEBACKFLOW_HPP
+#define FARNEBACKFLOW_HPP
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+
+#include <vector>
+#include <cfloat>
+#include <cmath>
+
+#include "exception.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Farneback optical flow, same algorithm as calcOpticalFlowFarneback(),
+     * which keeps polynomial expansion of every pyramid layer of last
+     * frame. When frame N becomes previous frame of next pair its
+     * expansion is reused, so expansion is computed once per frame
+     * instead of twice. Cache is keyed on pixels of previous frame, so 
+     * with --roi-flow it hits only when padded ROI of consecutive pairs 
+     * is the same rectangle, that is when player moved less than 
+     * alignment of padded ROI.
+     *
+     * Coefficients are stored planar (one CV_32FC1 per coefficient), so
+     * inner loops run over contiguous rows without tail handling and are
+     * vectorized by compiler for any, also odd, ROI width.
+     *
+     * Sums are in float instead of double, so flow differs from OpenCV
+     * only by float rounding. farnebackFlowTest measures endpoint error 
+     * and speed against calcOpticalFlowFarneback().
+     */
+    class FarnebackFlow {
+    private:
+        // Same as in calcOpticalFlowFarneback()
+        static const int MIN_SIZE = 32;
+        static const int BORDER = 5;
+
+        struct PolyLayer {
+            double scale;
+            Mat r[5];
+        };
+
+        double pyramidScale;
+        int pyramidLayers;
+        int windowSize;
+        int iterationsCount;
+        int neighbourSize;
+        double gaussianDeviation;
+        int operationFlags;
+
+        // Gaussian and its moments for k = 0..neighbourSize
+        vector<float> g, xg, xxg;
+        float ig11, ig03, ig33, ig55;
+
+        // Expansion of last frame and frame itself for cache check
+        Mat cachedGray;
+        vector<PolyLayer> prevLayers, layers;
+
+        Mat m[5], blurred[5];
+
+        void prepareGaussian();
+
+        bool isCached(const Mat& gray) const;
+
+        void expand(const Mat& gray, vector<PolyLayer>& layers) const;
+
+        void polyExp(const Mat& src, PolyLayer& layer) const;
+
+        void updateMatrices(const PolyLayer& r0, const PolyLayer& r1, const Mat& flow);
+
+        void updateFlow(Mat& flow);
+
+    public:
+        FarnebackFlow(double pyramidScale, int pyramidLayers, int windowSize,
+                int iterationsCount, int neighbourSize, double gaussianDeviation,
+                int operationFlags);
+
+        /**
+         * Calculates flow from prevGray to gray. If prevGray equals gray
+         * of last call, cached expansion is used.
+         *
+         * @param flow Output CV_32FC2 flow. With OPTFLOW_USE_INITIAL_FLOW
+         * it is also initial flow.
+         */
+        void calc(const Mat& prevGray, const Mat& gray, Mat& flow);
+
+        void reset();
+    };
+}
+
+#endif /* FARNEBACKFLOW_HPP */
+
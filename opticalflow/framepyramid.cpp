@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "framepyramid.hpp"
+
+using namespace gk;
+
+FramePyramid::FramePyramid(double pyramidScale, int pyramidLayers) 
+: pyramidScale(pyramidScale), pyramidLayers(pyramidLayers) {
+    
+    if (pyramidScale <= 0 || pyramidScale >= 1) {
+        throw Exception(__FILE__, __LINE__, "Pyramid scale must be in (0, 1).");
+    }
+}
+
+void FramePyramid::build(const Mat& gray) {
+    if (gray.channels() != 1) {
+        throw Exception(__FILE__, __LINE__, "Pyramid needs gray frame.");
+    }
+    
+    // Truncate layers like calcOpticalFlowFarneback()
+    int levelCount = 0;
+    double scale = 1;
+    for (; levelCount < pyramidLayers; levelCount++) {
+        scale *= pyramidScale;
+        if (gray.cols * scale < MIN_SIZE || gray.rows * scale < MIN_SIZE) {
+            break;
+        }
+    }
+    
+    levels.resize(levelCount + 1);
+    scales.resize(levelCount + 1);
+    
+    gray.convertTo(levels[0], CV_32F);
+    scales[0] = 1;
+    
+    Mat blurred;
+    scale = 1;
+    for (int k = 1; k <= levelCount; k++) {
+        scale *= pyramidScale;
+        
+        double sigma = (1. / scale - 1) * 0.5;
+        int smoothSize = cvRound(sigma * 5) | 1;
+        smoothSize = std::max(smoothSize, 3);
+        
+        Size size(cvRound(gray.cols * scale), cvRound(gray.rows * scale));
+        
+        GaussianBlur(levels[0], blurred, Size(smoothSize, smoothSize), sigma, sigma);
+        resize(blurred, levels[k], size, 0, 0, INTER_LINEAR);
+        scales[k] = scale;
+    }
+}
+
+bool FramePyramid::empty() const {
+    return levels.empty() || levels[0].empty();
+}
+
+int FramePyramid::getLevelCount() const {
+    return (int) levels.size();
+}
+
+const Mat& FramePyramid::getLevel(int level) const {
+    if (level < 0 || level >= (int) levels.size()) {
+        throw Exception(__FILE__, __LINE__, "Pyramid level out of range.");
+    }
+    return levels[level];
+}
+
+double FramePyramid::getScale(int level) const {
+    if (level < 0 || level >= (int) scales.size()) {
+        throw Exception(__FILE__, __LINE__, "Pyramid level out of range.");
+    }
+    return scales[level];
+}
+
+void FramePyramid::swap(FramePyramid& other) {
+    std::swap(pyramidScale, other.pyramidScale);
+    std::swap(pyramidLayers, other.pyramidLayers);
+    levels.swap(other.levels);
+    scales.swap(other.scales);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMEPYRAMID_HPP
+#define FRAMEPYRAMID_HPP
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <vector>
+
+#include "exception.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Gaussian pyramid of gray frame built the same way as inside
+     * calcOpticalFlowFarneback(). Every layer is blurred and resized from
+     * finest layer, so pyramid of frame N can be reused as previous 
+     * pyramid for frame N+1.
+     * 
+     * Finest layer (0) is not blurred. Layers are CV_32FC1.
+     */
+    class FramePyramid {
+    private:
+        // Same as in calcOpticalFlowFarneback()
+        static const int MIN_SIZE = 32;
+        
+        double pyramidScale;
+        int pyramidLayers;
+        
+        vector<Mat> levels;
+        vector<double> scales;
+
+    public:
+        FramePyramid(double pyramidScale, int pyramidLayers);
+        
+        /**
+         * Builds pyramid from gray frame. Layers which would be smaller
+         * than 32 px are truncated.
+         */
+        void build(const Mat& gray);
+        
+        bool empty() const;
+        
+        int getLevelCount() const;
+        
+        const Mat& getLevel(int level) const;
+        
+        /**
+         * Scale of layer relative to finest layer.
+         */
+        double getScale(int level) const;
+        
+        void swap(FramePyramid& other);
+    };
+}
+
+#endif /* FRAMEPYRAMID_HPP */
+
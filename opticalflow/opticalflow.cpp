@@ -23,8 +23,33 @@ using namespace gk;
 OpticalFlow::OpticalFlow(const OpticalFlowData& config, 
         const TrackerData& trackerData, 
         const std::shared_ptr<AmplitudeFactor> amplitudeFactor)
-: config(config), trackerData(trackerData), amplitudeFactor(amplitudeFactor){
+: config(config), trackerData(trackerData), amplitudeFactor(amplitudeFactor),
+  resampleScale(1, 1){
     
+    if (config.flowType == NATIVE_FARNEBACK) {
+        farnebackFlow = std::make_shared<FarnebackFlow>(
+                config.pyramidScale,
+                config.pyramidLayers,
+                config.windowSize,
+                config.iterationsCount,
+                config.neighbourSize,
+                config.gaussianDeviation,
+                config.operationFlags);
+    }
+    
+    if (config.flowType == DIS) {
+#ifdef OPTICAL_FLOW_DIS
+        disFlow = optflow::createOptFlow_DIS(config.disPreset);
+        if (config.disPatchSize > 0) {
+            disFlow->setPatchSize(config.disPatchSize);
+        }
+        if (config.disPatchStride > 0) {
+            disFlow->setPatchStride(config.disPatchStride);
+        }
+#else
+        throw Exception(__FILE__, __LINE__, "DIS optical flow needs OpenCV 3.2 or newer.");
+#endif
+    }
 }
 
 void OpticalFlow::calculateOpticalFlow(const UMat& uprevgray, const UMat& ugray, Mat& flow) {
@@ -60,7 +85,26 @@ void OpticalFlow::calculateOpticalFlow(const UMat& uprevgray, const UMat& ugray,
             break;
 
         case LUCAS_KANADE:
+            {
+                string message = "Lucas-Kanade is sparse and has no dense flow.";
+                throw Exception(__FILE__, __LINE__, message);
+            }
+
+        case NATIVE_FARNEBACK:
+            {
+                // Expansion of previous frame is reused from last call
+                Mat prevgray = uprevgray.getMat(ACCESS_READ);
+                Mat gray = ugray.getMat(ACCESS_READ);
+                farnebackFlow->calc(prevgray, gray, flow);
+            }
+            return;
+
+#ifdef OPTICAL_FLOW_DIS
+        case DIS:
+            // Input must be CV_8UC1, output is CV_32FC2 same as Farneback
+            disFlow->calc(uprevgray, ugray, uflow);
             break;
+#endif
 
         default:
             cerr << endl;
@@ -71,26 +115,94 @@ void OpticalFlow::calculateOpticalFlow(const UMat& uprevgray, const UMat& ugray,
     uflow.copyTo(flow);
 }
 
+void OpticalFlow::calculateOpticalFlow(const FramePyramid& prevPyramid,
+        const FramePyramid& pyramid, Mat& flow) {
+    
+    if (config.flowType != FARNEBACK) {
+        string message = "Shared pyramid is implemented only for Farneback.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    
+    int top = std::min(prevPyramid.getLevelCount(), pyramid.getLevelCount()) - 1;
+    int flags = config.operationFlags & ~OPTFLOW_USE_INITIAL_FLOW;
+    Mat levelFlow;
+    
+    for (int k = top; k >= 0; k--) {
+        const Mat& prevLevel = prevPyramid.getLevel(k);
+        const Mat& level = pyramid.getLevel(k);
+        
+        // Coarser flow is initial flow, same as inside Farneback
+        if (k < top) {
+            resize(flow, levelFlow, level.size(), 0, 0, INTER_LINEAR);
+            levelFlow *= pyramid.getScale(k) / pyramid.getScale(k + 1);
+        }
+        
+        calcOpticalFlowFarneback(prevLevel, level, levelFlow,
+                config.pyramidScale,
+                0,
+                config.windowSize,
+                config.iterationsCount,
+                config.neighbourSize,
+                config.gaussianDeviation,
+                k < top ? flags | OPTFLOW_USE_INITIAL_FLOW : flags
+                );
+        
+        std::swap(flow, levelFlow);
+    }
+}
+
+void OpticalFlow::getPolarFlow(const FramePyramid& prevPyramid, const FramePyramid& pyramid, 
+        const Rect2d& roi, Mat& flowAngle, Mat& flowMagnitude) {
+    
+    calculateOpticalFlow(prevPyramid, pyramid, flow);
+    
+    if (!flow.empty() && trackerData.trackerUsed) {
+        Rect2d scaledRoi;
+        getScaledRoi(roi, scaledRoi);
+
+        // Correct roi
+        Roi::correct<Rect2d>(scaledRoi, flow);
+        if (!Roi::insideImage(flow, scaledRoi)) {
+            string message = "ROI not inside image.";
+            throw Exception(__FILE__, __LINE__, message);
+        }
+        flow = Roi::crop<Rect2d>(flow, scaledRoi);
+    }
+    
+    toPolar(roi, flowAngle, flowMagnitude);
+}
+
 void OpticalFlow::getPolarFlow(const UMat& uprevgray, const UMat& ugray, const Rect2d& roi,
         Mat& flowAngle, Mat& flowMagnitude) {
 
+    // Sparse flow is calculated only on points inside ROI
+    if (config.flowType == LUCAS_KANADE) {
+        Rect2d scaledRoi;
+        {
+            Mat gray = ugray.getMat(ACCESS_READ);
+            if (trackerData.trackerUsed) {
+                getScaledRoi(roi, scaledRoi);
+                Roi::correct<Rect2d>(scaledRoi, gray);
+            } else {
+                scaledRoi = Rect2d(0, 0, gray.cols, gray.rows);
+            }
+        }
+        getPolarSparseFlow(uprevgray, ugray, scaledRoi, roi, flowAngle, flowMagnitude);
+        return;
+    }
+    
     calculateOpticalFlow(uprevgray, ugray, flow);
     
     // If no flow then angle = 0 and magnitude = 0
     if(flow.empty()){
-        flowAngle = Mat::zeros(roi.size(), CV_32FC1);
-        flowMagnitude = Mat::zeros(roi.size(), CV_32FC1);
+        toPolar(roi, flowAngle, flowMagnitude);
         return;
     }
 
     // If we have enabled tracker we must crop our flow 
     if(trackerData.trackerUsed){
         Rect2d scaledRoi;
-        if (trackerData.trackerDownScale > 0) {
-            Scaler::scaleRoi(roi, scaledRoi, trackerData.trackerUpScale);
-        } else {
-            scaledRoi = roi;
-        }
+        getScaledRoi(roi, scaledRoi);
 
         // Correct roi
         Roi::correct<Rect2d>(scaledRoi, flow);
@@ -100,6 +212,267 @@ void OpticalFlow::getPolarFlow(const UMat& uprevgray, const UMat& ugray, const R
         }
         flow = Roi::crop<Rect2d>(flow, scaledRoi);
     }
+    
+    toPolar(roi, flowAngle, flowMagnitude);
+}
+
+void OpticalFlow::getPolarRoiFlow(const Mat& prevFrame, const Mat& frame, const Rect2d& roi,
+        Mat& flowAngle, Mat& flowMagnitude) {
+    
+    Rect2d scaledRoi;
+    getScaledRoi(roi, scaledRoi);
+    Roi::correct<Rect2d>(scaledRoi, frame);
+    
+    // Frames without ROI don't need flow
+    if (Roi::isEmpty(scaledRoi)) {
+        flow.release();
+        toPolar(roi, flowAngle, flowMagnitude);
+        return;
+    }
+    if (!Roi::insideImage(frame, scaledRoi)) {
+        string message = "ROI not inside image.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    
+    // Flow is calculated on ROI with canonical diagonal
+    double resample = 1;
+    if (config.canonicalDiagonal > 0) {
+        resample = config.canonicalDiagonal / std::sqrt(
+                scaledRoi.width * scaledRoi.width + scaledRoi.height * scaledRoi.height);
+    }
+    
+    // Dilate ROI so that every pyramid layer sees whole neighbourhood
+    int margin = getRoiMargin(resample);
+    int left = cvFloor(scaledRoi.x) - margin;
+    int top = cvFloor(scaledRoi.y) - margin;
+    int right = cvCeil(scaledRoi.x + scaledRoi.width) + margin;
+    int bottom = cvCeil(scaledRoi.y + scaledRoi.height) + margin;
+    
+    // Pyramid layers of padded ROI sample the same pixels as layers of 
+    // full frame only if padded ROI starts and ends on grid of coarsest 
+    // layer. Resampled ROI has own grid anyway.
+    int align = 1;
+    double inverseScale = config.pyramidScale > 0 ? 1 / config.pyramidScale : 0;
+    if (config.canonicalDiagonal == 0 && std::abs(inverseScale - cvRound(inverseScale)) < 1e-6) {
+        for (int i = 0; i < config.pyramidLayers; i++) {
+            align *= cvRound(inverseScale);
+        }
+    }
+    left -= ((left % align) + align) % align;
+    top -= ((top % align) + align) % align;
+    right += (align - right % align) % align;
+    bottom += (align - bottom % align) % align;
+    
+    Rect paddedRoi(left, top, right - left, bottom - top);
+    paddedRoi &= Rect(0, 0, frame.cols, frame.rows);
+    
+    UMat uprevgray, ugray;
+    toGray(prevFrame(paddedRoi), uprevgray);
+    toGray(frame(paddedRoi), ugray);
+    
+    resampleScale = Point2d(1, 1);
+    if (config.canonicalDiagonal > 0) {
+        Size canonicalSize(std::max(cvRound(paddedRoi.width * resample), 1),
+                std::max(cvRound(paddedRoi.height * resample), 1));
+        int interpolation = resample < 1 ? INTER_AREA : INTER_LINEAR;
+        
+        UMat resized;
+        resize(uprevgray, resized, canonicalSize, 0, 0, interpolation);
+        std::swap(uprevgray, resized);
+        resize(ugray, resized, canonicalSize, 0, 0, interpolation);
+        std::swap(ugray, resized);
+        
+        // Rounding makes scale slightly different for x and y
+        resampleScale = Point2d(canonicalSize.width / (double) paddedRoi.width,
+                canonicalSize.height / (double) paddedRoi.height);
+    }
+    
+    Rect2d localRoi((scaledRoi.x - paddedRoi.x) * resampleScale.x, 
+            (scaledRoi.y - paddedRoi.y) * resampleScale.y,
+            scaledRoi.width * resampleScale.x, 
+            scaledRoi.height * resampleScale.y);
+    
+    if (config.flowType == LUCAS_KANADE) {
+        getPolarSparseFlow(uprevgray, ugray, localRoi, roi, flowAngle, flowMagnitude);
+        return;
+    }
+    
+    calculateOpticalFlow(uprevgray, ugray, flow);
+    
+    // Crop ROI from padded flow and return to frame pixels
+    if (!flow.empty()) {
+        Roi::correct<Rect2d>(localRoi, flow);
+        flow = Roi::crop<Rect2d>(flow, localRoi);
+        if (config.canonicalDiagonal > 0) {
+            multiply(flow, Scalar(1 / resampleScale.x, 1 / resampleScale.y), flow);
+        }
+    }
+    
+    toPolar(roi, flowAngle, flowMagnitude);
+}
+
+int OpticalFlow::getRoiMargin(const double resample) const {
+    int layers = config.pyramidScale > 0 && config.pyramidScale < 1 ? 
+        config.pyramidLayers : 0;
+    
+    // In pixels of finest layer, where flow is calculated
+    double margin = 0;
+    double scale = 1;
+    for (int k = 0; k <= layers; k++) {
+        // Expansion reads neighbourhood once, every iteration averages 
+        // flow of neighbours inside window
+        double layerMargin = config.neighbourSize + 
+                config.iterationsCount * (config.windowSize / 2);
+        margin += layerMargin / scale;
+        
+        // Frame is blurred before resize, same as in FramePyramid
+        double sigma = (1. / scale - 1) * 0.5;
+        int smoothSize = std::max(cvRound(sigma * 5) | 1, 3);
+        margin += smoothSize / 2;
+        
+        // Expansion of next frame is read at position moved by flow
+        margin += config.roiMaxDisplacement * resample;
+        
+        scale *= config.pyramidScale;
+    }
+    return cvCeil(margin / resample);
+}
+
+void OpticalFlow::getPolarSparseFlow(const UMat& uprevgray, const UMat& ugray,
+        const Rect2d& scaledRoi, const Rect2d& roi,
+        Mat& flowAngle, Mat& flowMagnitude) {
+    
+    Rect region(cvFloor(scaledRoi.x), cvFloor(scaledRoi.y),
+            cvFloor(scaledRoi.width), cvFloor(scaledRoi.height));
+    region &= Rect(0, 0, ugray.cols, ugray.rows);
+    
+    vector<Point2f> points, nextPoints;
+    if (region.area() > 0) {
+        getSparsePoints(uprevgray, region, points);
+    }
+    
+    // No points, no vectors
+    if (points.empty()) {
+        flowAngle.release();
+        flowMagnitude.release();
+        return;
+    }
+    
+    vector<uchar> status;
+    vector<float> error;
+    calcOpticalFlowPyrLK(uprevgray, ugray, points, nextPoints, status, error,
+            Size(config.windowSize, config.windowSize),
+            config.pyramidLayers,
+            TermCriteria(TermCriteria::COUNT | TermCriteria::EPS, 30, 0.01));
+    
+    Mat dx(1, (int) points.size(), CV_32FC1);
+    Mat dy(1, (int) points.size(), CV_32FC1);
+    int count = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (status[i]) {
+            dx.at<float>(count) = (nextPoints[i].x - points[i].x) / resampleScale.x;
+            dy.at<float>(count) = (nextPoints[i].y - points[i].y) / resampleScale.y;
+            count++;
+        }
+    }
+    
+    if (count == 0) {
+        flowAngle.release();
+        flowMagnitude.release();
+        return;
+    }
+    
+    cartToPolar(dx.colRange(0, count), dy.colRange(0, count), 
+            flowMagnitude, flowAngle, false);
+    
+    if (amplitudeFactor) {
+        amplitudeFactor->scale(flowMagnitude, roi);
+    }
+}
+
+void OpticalFlow::getSparsePoints(const UMat& gray, const Rect& region, 
+        vector<Point2f>& points) const {
+    
+    int budget = std::max(config.lkMaxPoints, 1);
+    
+    if (config.lkCorners) {
+        double minDistance = std::max(1.0, 
+                std::sqrt(region.area() / (double) budget) / 2);
+        goodFeaturesToTrack(gray(region), points, budget, 0.01, minDistance);
+        for (Point2f& point : points) {
+            point.x += region.x;
+            point.y += region.y;
+        }
+        return;
+    }
+    
+    // Regular grid with at most budget points
+    double step = std::max(1.0, std::sqrt(region.area() / (double) budget));
+    for (double y = region.y + step / 2; y < region.y + region.height; y += step) {
+        for (double x = region.x + step / 2; x < region.x + region.width; x += step) {
+            if ((int) points.size() >= budget) {
+                return;
+            }
+            points.push_back(Point2f((float) x, (float) y));
+        }
+    }
+}
+
+void OpticalFlow::setQuality(const FlowQuality& quality) {
+    config.iterationsCount = quality.iterationsCount;
+    config.pyramidLayers = quality.pyramidLayers;
+    config.windowSize = quality.windowSize;
+    
+    if (farnebackFlow) {
+        farnebackFlow = std::make_shared<FarnebackFlow>(
+                config.pyramidScale,
+                config.pyramidLayers,
+                config.windowSize,
+                config.iterationsCount,
+                config.neighbourSize,
+                config.gaussianDeviation,
+                config.operationFlags);
+    }
+}
+
+FlowQuality OpticalFlow::getQuality() const {
+    FlowQuality quality;
+    quality.iterationsCount = config.iterationsCount;
+    quality.pyramidLayers = config.pyramidLayers;
+    quality.windowSize = config.windowSize;
+    return quality;
+}
+
+const Mat& OpticalFlow::getFlow() const {
+    return flow;
+}
+
+float OpticalFlow::getAmplitudeFactor(const Rect2d& roi) const {
+    if (amplitudeFactor) {
+        return amplitudeFactor->getFactor(roi);
+    }
+    return 1.f;
+}
+
+void OpticalFlow::getScaledRoi(const Rect2d& roi, Rect2d& scaledRoi) const {
+    if (trackerData.trackerDownScale > 0) {
+        Scaler::scaleRoi(roi, scaledRoi, trackerData.trackerUpScale);
+    } else {
+        scaledRoi = roi;
+    }
+}
+
+void OpticalFlow::toPolar(const Rect2d& roi, Mat& flowAngle, Mat& flowMagnitude) {
+    // Histograms are calculated later directly from Cartesian flow
+    if (config.fusedHistogram) {
+        if (flow.empty()) {
+            flow = Mat::zeros(roi.size(), CV_32FC2);
+        }
+        flowAngle.release();
+        flowMagnitude.release();
+        return;
+    }
+    
     // After cropping there could be empty flow
     if(flow.empty()){
         flowAngle = Mat::zeros(roi.size(), CV_32FC1);
@@ -117,3 +490,15 @@ void OpticalFlow::getPolarFlow(const UMat& uprevgray, const UMat& ugray, const R
         amplitudeFactor->scale(flowMagnitude, roi);
     }
 }
+
+void OpticalFlow::toGray(const Mat& image, UMat& gray) {
+    if (image.channels() == 3) {
+        cvtColor(image, gray, COLOR_BGR2GRAY);
+
+    } else if (image.channels() == 1) {
+        image.copyTo(gray);
+
+    } else {
+        throw Exception(__FILE__, __LINE__, "Frame has oddly number of channels");
+    }
+}
@@ -31,6 +31,13 @@
 #include "scaler.hpp"
 #include "exception.hpp"
 #include "basetrackerfile.hpp"
+#include "framepyramid.hpp"
+#include "farnebackflow.hpp"
+
+// DISOpticalFlow is in optflow module since OpenCV 3.2
+#if CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 2)
+#define OPTICAL_FLOW_DIS
+#endif
 
 using namespace cv;
 using namespace std;
@@ -39,12 +46,31 @@ namespace gk{
     
     enum OpticalFlowType {
         FARNEBACK,
-        LUCAS_KANADE
+        LUCAS_KANADE,
+        // Farneback with cached polynomial expansion, see FarnebackFlow
+        NATIVE_FARNEBACK,
+        // Dense inverse search from optflow module, needs OPTICAL_FLOW_DIS
+        DIS
+    };
+
+    // Farneback parameters that QualityScheduler changes during run
+    struct FlowQuality {
+        int iterationsCount;
+        int pyramidLayers;
+        int windowSize;
     };
 
     struct OpticalFlowData {
         bool needVideo;
         int startFrame;
+        // Frames decoded ahead on own thread, 0 decodes synchronously
+        int decodeDepth;
+        // Depth PNG frames decoded ahead on prefetch threads, 0 decodes 
+        // them synchronously
+        int prefetchDepth;
+        int prefetchThreads;
+        // Decoder gives gray frames, color is kept only for output video
+        bool lumaDecode;
         string outFlowVideo;
         string outVideo;
         bool displayFlow;
@@ -57,6 +83,34 @@ namespace gk{
         int neighbourSize;
         double gaussianDeviation;
         int operationFlags;
+        // DIS optical flow parameters
+        // Preset is one of optflow::DISOpticalFlow::PRESET_*, unused 
+        // without OPTICAL_FLOW_DIS
+        int disPreset;
+        // Overrides preset if > 0
+        int disPatchSize;
+        int disPatchStride;
+        // Sparse Lucas-Kanade parameters
+        // Max tracked points per frame
+        int lkMaxPoints;
+        // Track corners instead of regular grid
+        bool lkCorners;
+        // Calculate flow only on tracker ROI padded by getRoiMargin()
+        bool roiFlow;
+        // Largest expected displacement between frames in frame pixels, 
+        // part of ROI margin
+        int roiMaxDisplacement;
+        // With roiFlow resample padded ROI so that ROI diagonal has this
+        // many pixels, 0 keeps native size
+        int canonicalDiagonal;
+        // Reuse frame pyramid of frame N as previous pyramid for frame N+1
+        bool sharedPyramid;
+        // Keep Cartesian flow for FlowDescriptor instead of polar flow
+        bool fusedHistogram;
+        // Adapt Farneback quality to hold this fps, 0 keeps quality fixed
+        double targetFps;
+        // Lowest quality QualityScheduler may use
+        FlowQuality minQuality;
     };
     
     class OpticalFlow{
@@ -67,13 +121,109 @@ namespace gk{
         std::shared_ptr<AmplitudeFactor> amplitudeFactor;
         Mat flow;
         TrackerData trackerData;
+        std::shared_ptr<FarnebackFlow> farnebackFlow;
+#ifdef OPTICAL_FLOW_DIS
+        Ptr<optflow::DISOpticalFlow> disFlow;
+#endif
+        // Size of frame pixel in pixels of last flow, see canonicalDiagonal
+        Point2d resampleScale;
 
         void calculateOpticalFlow(const UMat& uprevgray, const UMat& ugray, Mat& flow);
         
+        void calculateOpticalFlow(const FramePyramid& prevPyramid, 
+                const FramePyramid& pyramid, Mat& flow);
+        
+        void getScaledRoi(const Rect2d& roi, Rect2d& scaledRoi) const;
+        
+        /**
+         * Tracks at most lkMaxPoints points inside scaledRoi with pyramidal
+         * Lucas-Kanade. Angle and magnitude are 1xN, one value per tracked
+         * point, so descriptors use them without dense flow field.
+         */
+        void getPolarSparseFlow(const UMat& uprevgray, const UMat& ugray,
+                const Rect2d& scaledRoi, const Rect2d& roi,
+                Mat& flowAngle, Mat& flowMagnitude);
+        
+        void getSparsePoints(const UMat& gray, const Rect& region, 
+                vector<Point2f>& points) const;
+        
+        void toPolar(const Rect2d& roi, Mat& flowAngle, Mat& flowMagnitude);
+        
+        static void toGray(const Mat& image, UMat& gray);
+        
     public:
         OpticalFlow(const OpticalFlowData& config, const TrackerData& trackerData, const std::shared_ptr<AmplitudeFactor> amplitudeFactor);
         void getPolarFlow(const UMat& uprevgray, const UMat& ugray, const Rect2d& roi,
                 Mat& flowAngle, Mat& flowMagnitude);
+        
+        /**
+         * Calculates Farneback flow layer by layer on prebuilt pyramids, 
+         * from coarsest to finest, where flow of coarser layer is initial
+         * flow for finer layer.
+         * 
+         * Finest layer equals calcOpticalFlowFarneback() on whole frame.
+         * Coarser layers are additionally smoothed with 3x3 gaussian,
+         * because Farneback always blurs its input.
+         */
+        void getPolarFlow(const FramePyramid& prevPyramid, const FramePyramid& pyramid,
+                const Rect2d& roi, Mat& flowAngle, Mat& flowMagnitude);
+        
+        /**
+         * Calculates optical flow only on ROI dilated by getRoiMargin().
+         * Frames can be BGR or gray, because only padded ROI is converted
+         * to gray. If scaled ROI is empty flow is not calculated at all.
+         * 
+         * Padded ROI is aligned to pixel grid of coarsest pyramid layer, so
+         * every layer samples the same pixels as on full frame. Flow inside 
+         * ROI then matches flow cropped from full frame up to sub-pixel 
+         * endpoint error, as long as no displacement is above 
+         * roiMaxDisplacement. Larger differences appear when padded ROI is 
+         * smaller than 32 px on coarsest pyramid layer, because Farneback 
+         * then uses less pyramid layers.
+         * 
+         * With canonicalDiagonal padded ROI is resized so that ROI diagonal
+         * is canonicalDiagonal pixels and cost doesn't depend on player 
+         * size. Flow is divided by known resample factor, so angle and 
+         * magnitude are in frame pixels as without resampling.
+         * 
+         * @param prevFrame Previous frame in full resolution.
+         * @param frame Current frame in full resolution.
+         * @param roi Tracker ROI.
+         */
+        void getPolarRoiFlow(const Mat& prevFrame, const Mat& frame, const Rect2d& roi,
+                Mat& flowAngle, Mat& flowMagnitude);
+        
+        /**
+         * Margin in frame pixels around ROI that Farneback needs so that 
+         * flow inside ROI depends only on pixels that full frame flow 
+         * depends on. On every pyramid layer polynomial neighbourhood, one 
+         * averaging window per iteration, pyramid blur and warp by 
+         * roiMaxDisplacement are added, and coarser layers are enlarged by
+         * 1/pyramidScale per layer.
+         * 
+         * @param resample Flow pixels per frame pixel, see canonicalDiagonal.
+         */
+        int getRoiMargin(const double resample = 1) const;
+        
+        /**
+         * Changes Farneback parameters for next frames. Native Farneback
+         * is recreated, so its expansion cache is lost once.
+         */
+        void setQuality(const FlowQuality& quality);
+        
+        FlowQuality getQuality() const;
+        
+        /**
+         * Cartesian flow cropped to ROI from last getPolar*() call. With 
+         * fusedHistogram angle and magnitude are not calculated and this
+         * flow is used instead.
+         */
+        const Mat& getFlow() const;
+        
+        /**
+         * Factor for magnitudes in ROI or 1 if there is no amplitude factor.
+         */
+        float getAmplitudeFactor(const Rect2d& roi) const;
     };
 }
 
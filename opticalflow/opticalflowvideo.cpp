@@ -86,10 +86,13 @@ void OpticalFlowVideo::getFrame(const Mat& image, Mat& frame){
 }
 
 void OpticalFlowVideo::write(const Mat& flowAngle, const Mat& flowMagnitude){
-    if(videoWriter.isOpened()){
-        Mat image;
-        getImage(flowAngle, flowMagnitude, image);
+    Mat image;
+    getImage(flowAngle, flowMagnitude, image);
+    writeImage(image);
+}
 
+void OpticalFlowVideo::writeImage(const Mat& image){
+    if(videoWriter.isOpened()){
         if (image.cols == frameSize.width && image.rows == frameSize.height) {
 /* 
 #ifdef DEBUG
@@ -119,4 +122,4 @@ void OpticalFlowVideo::write(const Mat& flowAngle, const Mat& flowMagnitude){
              << filename << endl;
         cerr << "Video will not be written." << endl;
     }
-}
\ No newline at end of file
+}
@@ -46,6 +46,9 @@ namespace gk {
         void getImage(const Mat& flowAngle, const Mat& flowMagnitude, Mat& image);
         void getFrame(const Mat& image, Mat& frame);
         void write(const Mat& flowAngle, const Mat& flowMagnitude);
+        
+        // Writes image from getImage(), so it can be colorized on other thread
+        void writeImage(const Mat& image);
 
     };
 }
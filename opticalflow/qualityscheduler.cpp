@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qualityscheduler.hpp"
+
+using namespace gk;
+
+const double QualityScheduler::SMOOTHING = 0.2;
+const double QualityScheduler::HEADROOM = 0.7;
+
+QualityScheduler::QualityScheduler(const OpticalFlowData& config)
+: budget(1000.0 / config.targetFps),
+level(LEVEL_COUNT - 1),
+latency(0),
+framesSinceChange(0) {
+
+    maxQuality.iterationsCount = config.iterationsCount;
+    maxQuality.pyramidLayers = config.pyramidLayers;
+    maxQuality.windowSize = config.windowSize;
+    minQuality = config.minQuality;
+}
+
+bool QualityScheduler::update(double frameLatency) {
+    // First frame starts smoothing
+    if (latency <= 0) {
+        latency = frameLatency;
+    } else {
+        latency = SMOOTHING * frameLatency + (1 - SMOOTHING) * latency;
+    }
+    framesSinceChange++;
+
+    int nextLevel = level;
+    if (latency > budget && framesSinceChange >= LOWER_DELAY) {
+        nextLevel = std::max(level - 1, 0);
+    } else if (latency < HEADROOM * budget && framesSinceChange >= RAISE_DELAY) {
+        nextLevel = std::min(level + 1, LEVEL_COUNT - 1);
+    }
+
+    if (nextLevel == level) {
+        return false;
+    }
+    level = nextLevel;
+    framesSinceChange = 0;
+    return true;
+}
+
+int QualityScheduler::interpolate(int minValue, int maxValue, int level) {
+    return minValue + cvRound((maxValue - minValue) * level / (double) (LEVEL_COUNT - 1));
+}
+
+FlowQuality QualityScheduler::getQuality() const {
+    FlowQuality quality;
+    quality.iterationsCount = interpolate(
+            minQuality.iterationsCount, maxQuality.iterationsCount, level);
+    quality.pyramidLayers = interpolate(
+            minQuality.pyramidLayers, maxQuality.pyramidLayers, level);
+    quality.windowSize = interpolate(
+            minQuality.windowSize, maxQuality.windowSize, level);
+    return quality;
+}
+
+int QualityScheduler::getLevel() const {
+    return level;
+}
+
+bool QualityScheduler::isDegraded() const {
+    return level < LEVEL_COUNT - 1;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUALITYSCHEDULER_HPP
+#define QUALITYSCHEDULER_HPP
+
+#include <opencv2/core/core.hpp>
+
+#include <algorithm>
+
+#include "opticalflow.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Holds target fps by lowering and raising flow quality. Quality 
+     * levels are linear steps from minimal quality (level 0) to quality
+     * given by OpticalFlowData (top level), which is also start level.
+     * 
+     * Latency is smoothed, quality is lowered when smoothed latency is 
+     * over frame budget and raised only when it is well below budget for
+     * longer time, so quality doesn't oscillate.
+     */
+    class QualityScheduler {
+    private:
+        static const int LEVEL_COUNT = 8;
+        // Weight of new latency in smoothed latency
+        static const double SMOOTHING;
+        // Raise quality only below this part of budget
+        static const double HEADROOM;
+        // Frames after change before next lowering or raising
+        static const int LOWER_DELAY = 5;
+        static const int RAISE_DELAY = 30;
+
+        FlowQuality minQuality;
+        FlowQuality maxQuality;
+        double budget;
+
+        int level;
+        double latency;
+        int framesSinceChange;
+
+        static int interpolate(int minValue, int maxValue, int level);
+
+    public:
+        QualityScheduler(const OpticalFlowData& config);
+
+        /**
+         * Adds latency of last frame. Only flow calculation should be 
+         * timed, as only it depends on quality.
+         * 
+         * @param frameLatency Latency in milliseconds.
+         * @return True if quality level changed.
+         */
+        bool update(double frameLatency);
+
+        FlowQuality getQuality() const;
+
+        int getLevel() const;
+
+        bool isDegraded() const;
+    };
+}
+
+#endif /* QUALITYSCHEDULER_HPP */
+
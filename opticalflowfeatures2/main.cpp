@@ -24,10 +24,12 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
 
 // local
 #include "angledescriptor.hpp"
 #include "amplitudedescriptor.hpp"
+#include "flowdescriptor.hpp"
 #include "histogramfile.hpp"
 #include "roi.hpp"
 #include "videotimer.hpp"
@@ -37,9 +39,15 @@
 #include "opticalflowvideo.hpp"
 #include "cameraselector.hpp"
 #include "selectorfile.hpp"
+#include "selectionplanfile.hpp"
 #include "timefilewriter.hpp"
 #include "of2databox.hpp"
 #include "flofile.hpp"
+#include "qualityfile.hpp"
+#include "qualityscheduler.hpp"
+#include "pipeline.hpp"
+#include "threadpool.hpp"
+#include "executor.hpp"
 #include "config.hpp"
 
 using namespace cv;
@@ -49,12 +57,37 @@ using namespace gk;
 static const string DISPLAY_WINDOW_FLOW = "Optical flow";
 static const int BOUNDING_BOX_THICKNESS = 2;
 
+// Everything that later stages need from one frame pair
+struct FrameJob {
+    int frame;
+    bool confident;
+    long timeStamp;
+    Rect2d roi;
+    // Selected camera and its frames, when flow is calculated by flow stage
+    int camera;
+    FramePair pair;
+    // Polar flow or, with fused histogram, Cartesian flow of selected camera
+    Mat angle, magnitude;
+    Mat flow;
+    float amplitudeFactor;
+    // Color frame, only for output video
+    Mat image;
+    vector<float> histogram;
+    Mat flowImage, flowFrame;
+    QualityRecord quality;
+};
+
 //Mat frame, image;
 static void printErrorHeader(int line){
     cerr << endl;
     cerr << "File: " << __FILE__ << " line: " << line << endl;
 }
 
+static bool isSameQuality(const FlowQuality& a, const FlowQuality& b) {
+    return a.iterationsCount == b.iterationsCount && 
+            a.pyramidLayers == b.pyramidLayers && a.windowSize == b.windowSize;
+}
+
 static void printErrorFooter(){
     cerr << "Aborting program..." << endl;
     cerr << endl;
@@ -76,6 +109,10 @@ int main(int argc, char** argv) {
 
 
     /// DESCRIPTORS
+    // Histogram loops use chosen instruction set
+    HistogramKernels::setIsa(terminalParser.descriptorIsa);
+    cout << "Descriptor ISA: " << HistogramKernels::getName(HistogramKernels::getIsa()) << endl;
+
     // Get descriptors
     std::shared_ptr<gk::AmplitudeDescriptor> amplitudeDescriptor = NULL;
     if (terminalParser.amplitudeDescriptorData.binCount > 0) {
@@ -88,27 +125,54 @@ int main(int argc, char** argv) {
         angleDescriptor = std::make_shared<AngleDescriptor>(terminalParser.angleDescriptorData);
     }
 
-    // All initial values are 0.0
-    vector<float> angleHistogram;
-    vector<float> amplitudeHistogram;  
-    vector<float> normalizedHistogram;
+    // Both histograms in one pass over Cartesian flow
+    std::shared_ptr<gk::FlowDescriptor> flowDescriptor = NULL;
+    if (terminalParser.opticalFlowData.fusedHistogram) {
+        flowDescriptor = std::make_shared<FlowDescriptor>(angleDescriptor, amplitudeDescriptor);
+    }
     /// DESCRIPTORS
 
 
     /// CAMERA SELECTOR
-    SelectorFile selectorFile(terminalParser.cameraSelectorFilename);
-    CameraSelectorData data;
+    // Precomputed plan or selection from metric centers
+    std::shared_ptr<gk::SelectionPlan> selectionPlan = NULL;
+    std::shared_ptr<gk::CameraSelector> cameraSelector = NULL;
     try{
-        data = selectorFile.getNext();
+        if (!terminalParser.selectionPlanFilename.empty()) {
+            SelectionPlanFileReader planFile(terminalParser.selectionPlanFilename);
+            selectionPlan = std::make_shared<SelectionPlan>(planFile.getNext());
+            
+        } else {
+            SelectorFile selectorFile(terminalParser.cameraSelectorFilename);
+            cameraSelector = std::make_shared<CameraSelector>(selectorFile.getNext());
+        }
     } catch(std::exception& e){
         printErrorHeader(__LINE__);
         cerr << e.what() << endl;
         printErrorFooter();
 
     }
-    CameraSelector cameraSelector(data);
     /// CAMERA SELECTOR
     
+    
+    /// FRAME RANGE
+    // Frames count from 1 as in tracker files. First frame has no flow.
+    long startFrame = std::max(terminalParser.startFrame, 1L);
+    // Last frame with flow, -1 for end of video
+    long lastFrame = -1;
+    if (selectionPlan) {
+        lastFrame = selectionPlan->getLastFrame();
+    }
+    if (terminalParser.shardData.count > 1) {
+        // One frame of overlap gives previous frame to first flow of shard
+        long firstFrame;
+        selectionPlan->getShard(terminalParser.shardData.count, 
+                terminalParser.shardData.index, firstFrame, lastFrame);
+        startFrame = firstFrame - 1;
+        cout << "Shard " << terminalParser.shardData.index << ": frames " 
+                << firstFrame << " to " << lastFrame << endl;
+    }
+    /// FRAME RANGE
 
     
     /// FILE WRITERS  
@@ -118,8 +182,23 @@ int main(int argc, char** argv) {
     }
     HistogramFile histogramFile(terminalParser.outHistFilename);
     TimeFileWriter timeFileWriter(terminalParser.outTimeFilename);
+    std::shared_ptr<gk::QualityFile> qualityFile = NULL;
+    if(!terminalParser.outQualityFilename.empty()){
+        qualityFile = std::make_shared<QualityFile>(terminalParser.outQualityFilename);
+    }
     /// FILE WRITERS
 
+
+    /// QUALITY SCHEDULER
+    // Lowers flow quality when frames take longer than target fps allows
+    std::shared_ptr<gk::QualityScheduler> qualityScheduler = NULL;
+    // Update stage reads quality while flow workers adapt it
+    std::mutex qualityMutex;
+    if (terminalParser.opticalFlowData.targetFps > 0) {
+        qualityScheduler = std::make_shared<QualityScheduler>(terminalParser.opticalFlowData);
+    }
+    /// QUALITY SCHEDULER
+
     
     /// CONTAINERS
     std::vector< std::shared_ptr<OF2DataBox> > dataBoxes;
@@ -132,15 +211,34 @@ int main(int argc, char** argv) {
                 terminalParser.intrinsicFilenames[i],
                 terminalParser.extrinsicFilenames[i],
                 terminalParser.diagFilenames[i],
-                terminalParser.startFrame,
+                startFrame,
                 terminalParser.opticalFlowData,
-                terminalParser.trackerData);
+                terminalParser.trackerData,
+                selectionPlan,
+                i);
 
         dataBoxes.push_back(dataBox);
     }
     /// CONTAINERS
     
     
+    /// CAMERA THREADS
+    // Cameras are independent until selection, calling thread updates one too
+    int cameraThreads = terminalParser.pipelineData.cameraThreads;
+    if (cameraThreads < 0) {
+        cameraThreads = (int) dataBoxes.size() - 1;
+    }
+    // Flow workers calculate frames at once, without them camera threads 
+    // do. Both run at the same time, so each gets own cores. The rest of 
+    // cores goes to OpenCV inside every frame.
+    int flowThreads = terminalParser.pipelineData.flowThreads;
+    Executor executor(terminalParser.executorData, flowThreads > 1 ? flowThreads : 0, 
+            cameraThreads);
+    ThreadPool& cameraPool = executor.getCameraPool();
+    executor.printSplit();
+    /// CAMERA THREADS
+    
+    
 
     /// VIDEOS
     std::shared_ptr<OpticalFlowVideo> opticalFlowVideoWriter = NULL;
@@ -162,182 +260,335 @@ int main(int argc, char** argv) {
     cout << "=======================" << endl;
     cout << "Starting optical flow estimation..." << endl;
 
-    Mat opticalFlowImage, opticalFlowFrame;
     bool constructDisplayWindowFlow = true;
     bool changeDisplayWindowImageFlow = false;
+    bool needFlowImage = terminalParser.opticalFlowData.needVideo || 
+            terminalParser.opticalFlowData.displayFlow;
 
-    vector<Point3d> metricCenters;  
-    int selected = -1;
+    vector<Point3d> metricCenters;
     vector<bool> videosEnd;
+    // Not vector<bool>, cameras write it from different threads
+    vector<char> updated(dataBoxes.size());
+    int f = 0;
     
     
-    for (int f = 1;; f++) {     
-        
-        for(auto dataBox : dataBoxes){
-            if(!dataBox->update()){
-                videosEnd.push_back(true);
+    /// FLOW STATES
+    // Every flow worker has own flow state for every camera
+    vector< vector< std::shared_ptr<OpticalFlow> > > flowStates(flowThreads);
+    if (flowThreads > 1) {
+        for (auto& workerStates : flowStates) {
+            for (auto dataBox : dataBoxes) {
+                workerStates.push_back(dataBox->createOpticalFlow());
             }
-            metricCenters.push_back(dataBox->metricCenter);
         }
-
-        if(videosEnd.size() == dataBoxes.size()){
-            break;
+    }
+    /// FLOW STATES
+    
+    
+    /// UPDATE STAGE
+    // Reads all cameras, selects camera, calculates flow only for it and 
+    // copies the flow, because data boxes reuse their buffers for next frame
+    auto updateStage = [&](FrameJob& job) -> bool {
+        // Pipeline thread updates first camera
+        if (f == 0) {
+            executor.pinCameraThread();
+        }
+        
+        for (;;) {
+            f++;
+            
+            // Frame f of video is frame startFrame + f - 1 of tracker
+            long frame = startFrame + f - 1;
+            if (lastFrame >= 0 && frame > lastFrame) {
+                return false;
+            }
             
-        }else{
+            cameraPool.run(dataBoxes.size(), [&](size_t i) {
+                updated[i] = dataBoxes[i]->update();
+            });
+            
+            metricCenters.clear();
             videosEnd.clear();
-        }
+            for (size_t i = 0; i < dataBoxes.size(); i++) {
+                if(!updated[i]){
+                    videosEnd.push_back(true);
+                }
+                metricCenters.push_back(dataBoxes[i]->metricCenter);
+            }
 
+            if(videosEnd.size() == dataBoxes.size()){
+                return false;
+            }
+            
+            // Show % for user
+            if (dataBoxes[0]->timer->isTimeToShowOutput()) {
+                printf("\rFPS: %s\tCompletion: %s %%\tVideo time: %.2f\tFrame: %.2f\tElapsed: %s\tEstimated: %s",
+                        dataBoxes[0]->timer->getFps().c_str(),
+                        dataBoxes[0]->timer->getCompletion().c_str(),
+                        dataBoxes[0]->video->get(CAP_PROP_POS_MSEC) / 1000.0,
+                        dataBoxes[0]->video->get(CAP_PROP_POS_FRAMES),
+                        dataBoxes[0]->timer->getElapsedTime()->c_str(),
+                        dataBoxes[0]->timer->getEstimatedTime().c_str()
+                        );
+                fflush(stdout);
+            }
+            
+            // First frame has no flow
+            if (f == 1) {
+                continue;
+            }
+            
+            int selected;
+            if (selectionPlan) {
+                selected = selectionPlan->getSelected(frame);
+            } else {
+                selected = cameraSelector->select(metricCenters);
+            }
+            std::shared_ptr<OF2DataBox> selectedBox = dataBoxes[selected];
+            
+            job.frame = f;
+            job.confident = selectedBox->confident;
+            job.timeStamp = selectedBox->timeStamp;
+            job.roi = *selectedBox->roi;
+            if (flowThreads > 1) {
+                // Flow stage calculates it
+                job.camera = selected;
+                selectedBox->getFramePair(job.pair);
+                
+            } else {
+                int64 flowStart = getTickCount();
+                selectedBox->calculateFlow();
+                job.quality.latency = (getTickCount() - flowStart) * 1000.0 / getTickFrequency();
+                job.amplitudeFactor = selectedBox->amplitudeFactor;
+                selectedBox->angle.copyTo(job.angle);
+                selectedBox->magnitude.copyTo(job.magnitude);
+                if (flowDescriptor) {
+                    selectedBox->flow.copyTo(job.flow);
+                }
+            }
+            if (terminalParser.opticalFlowData.needVideo) {
+                selectedBox->frame.copyTo(job.image);
+            }
+            
+            // Log quality used for this frame and adapt it for next frames.
+            // Latency is of flow only, camera updates don't depend on 
+            // quality.
+            if (qualityScheduler) {
+                std::lock_guard<std::mutex> lock(qualityMutex);
+                FlowQuality quality = qualityScheduler->getQuality();
+                
+                job.quality.timeStamp = job.timeStamp;
+                job.quality.level = qualityScheduler->getLevel();
+                job.quality.degraded = qualityScheduler->isDegraded();
+                job.quality.iterationsCount = quality.iterationsCount;
+                job.quality.pyramidLayers = quality.pyramidLayers;
+                job.quality.windowSize = quality.windowSize;
+                
+                // Flow stage adapts quality when it calculates flow
+                if (flowThreads <= 1 && qualityScheduler->update(job.quality.latency)) {
+                    quality = qualityScheduler->getQuality();
+                    for (auto dataBox : dataBoxes) {
+                        dataBox->setFlowQuality(quality);
+                    }
+                }
+            }
+            return true;
+        }
+    };
+    /// UPDATE STAGE
+    
+    
+    /// FLOW STAGE
+    // Frame pairs don't depend on each other, so every worker takes any 
+    // pair. Later ordered stages get them in frame order again.
+    // Not vector<bool>, workers write it from different threads
+    vector<char> pinned(flowThreads);
+    auto flowStage = [&](FrameJob& job, int worker) {
+        if (!pinned[worker]) {
+            executor.pinWorker(worker);
+            pinned[worker] = true;
+        }
         
- 
+        OpticalFlow& opticalFlow = *flowStates[worker][job.camera];
+        if (qualityScheduler) {
+            // Quality scheduled when frame was selected
+            FlowQuality quality;
+            quality.iterationsCount = job.quality.iterationsCount;
+            quality.pyramidLayers = job.quality.pyramidLayers;
+            quality.windowSize = job.quality.windowSize;
+            if (!isSameQuality(opticalFlow.getQuality(), quality)) {
+                opticalFlow.setQuality(quality);
+            }
+        }
+        
+        int64 flowStart = getTickCount();
+        OF2DataBox::calculatePairFlow(opticalFlow, terminalParser.opticalFlowData,
+                job.pair, job.angle, job.magnitude, job.flow, job.amplitudeFactor);
+        if (qualityScheduler) {
+            job.quality.latency = (getTickCount() - flowStart) * 1000.0 / getTickFrequency();
+            
+            // Workers calculate flowThreads frames at once, so frame may
+            // take flowThreads frame budgets
+            std::lock_guard<std::mutex> lock(qualityMutex);
+            qualityScheduler->update(job.quality.latency / flowThreads);
+        }
+        // Cartesian flow is view of flow state, which next pair overwrites
+        if (!job.flow.empty()) {
+            job.flow = job.flow.clone();
+        }
+        job.pair = FramePair();
+    };
+    /// FLOW STAGE
+    
+    
+    /// DESCRIPTOR STAGE
+    // Stateless, runs on several threads
+    auto descriptorStage = [&](FrameJob& job) {
+        // All initial values are 0.0
+        vector<float> angleHistogram;
+        vector<float> amplitudeHistogram;
         
-        if(f > 1){
-            selected = cameraSelector.select(metricCenters);
+        if (flowDescriptor) {
+            if (angleDescriptor) {
+                angleHistogram = vector<float>(angleDescriptor->getBinCount());
+            }
+            if (amplitudeDescriptor) {
+                amplitudeHistogram = vector<float>(amplitudeDescriptor->getBinCount());
+            }
 
+            if (job.confident) {
+                flowDescriptor->getHistograms(job.flow, job.amplitudeFactor,
+                        angleHistogram, amplitudeHistogram);
+            }
 
+        } else {
             if (angleDescriptor) {
                 angleHistogram = vector<float>(amplitudeDescriptor->getBinCount());
-                
-                if(dataBoxes[selected]->confident) {
+
+                if(job.confident) {
                     // Normalize angles
                     Mat normalizedFlowAngle;
-                    dataBoxes[selected]->angle.copyTo(normalizedFlowAngle);
+                    job.angle.copyTo(normalizedFlowAngle);
                     AngleDescriptor::normalizeAngles(normalizedFlowAngle);
 
                     // Calculate normalized histogram
-                    angleDescriptor->getHistogram(normalizedFlowAngle, dataBoxes[selected]->magnitude, angleHistogram);
+                    angleDescriptor->getHistogram(normalizedFlowAngle, job.magnitude, angleHistogram);
                 }
             }
 
             if (amplitudeDescriptor) {
                 amplitudeHistogram = vector<float>(amplitudeDescriptor->getBinCount());
-                
-                if(dataBoxes[selected]->confident) {
-                    amplitudeDescriptor->getHistogram(dataBoxes[selected]->magnitude, amplitudeHistogram);
+
+                if(job.confident) {
+                    amplitudeDescriptor->getHistogram(job.magnitude, amplitudeHistogram);
                 }
             }
-            
-            
-            normalizedHistogram.clear();
-            if (amplitudeDescriptor && angleDescriptor) {
-                normalizedHistogram.insert(normalizedHistogram.begin(),
-                        angleHistogram.begin(), angleHistogram.end());
-                normalizedHistogram.insert(normalizedHistogram.end(),
-                        amplitudeHistogram.begin(), amplitudeHistogram.end());
-                
-            } else if(angleDescriptor){
-                normalizedHistogram.insert(normalizedHistogram.begin(),
-                        angleHistogram.begin(), angleHistogram.end());
-                
-            } else if (amplitudeDescriptor) {
-                normalizedHistogram.insert(normalizedHistogram.begin(),
-                        amplitudeHistogram.begin(), amplitudeHistogram.end());
-            }
-            
-            // Write normalized histogram to csv file
-            histogramFile.write(normalizedHistogram);
-            timeFileWriter.write(dataBoxes[selected]->timeStamp);
-
         }
 
+        job.histogram.clear();
+        if (amplitudeDescriptor && angleDescriptor) {
+            job.histogram.insert(job.histogram.begin(),
+                    angleHistogram.begin(), angleHistogram.end());
+            job.histogram.insert(job.histogram.end(),
+                    amplitudeHistogram.begin(), amplitudeHistogram.end());
 
-     
-
+        } else if(angleDescriptor){
+            job.histogram.insert(job.histogram.begin(),
+                    angleHistogram.begin(), angleHistogram.end());
 
-
-        // Show % for user
-        if (dataBoxes[0]->timer->isTimeToShowOutput()) {
-            const char* completion = dataBoxes[0]->timer->getCompletion().c_str();
-            printf("\rFPS: %s\tCompletion: %s %%\tVideo time: %.2f\tFrame: %.2f\tElapsed: %s\tEstimated: %s",
-                    dataBoxes[0]->timer->getFps().c_str(),
-                    dataBoxes[0]->timer->getCompletion().c_str(),
-                    dataBoxes[0]->video->get(CAP_PROP_POS_MSEC) / 1000.0,
-                    dataBoxes[0]->video->get(CAP_PROP_POS_FRAMES),
-                    dataBoxes[0]->timer->getElapsedTime()->c_str(),
-                    dataBoxes[0]->timer->getEstimatedTime().c_str()
-                    );
-            fflush(stdout);
+        } else if (amplitudeDescriptor) {
+            job.histogram.insert(job.histogram.begin(),
+                    amplitudeHistogram.begin(), amplitudeHistogram.end());
+        }
+    };
+    /// DESCRIPTOR STAGE
+    
+    
+    /// COLORIZE STAGE
+    // Stateless, runs on several threads
+    auto colorizeStage = [&](FrameJob& job) {
+        opticalFlowVideoWriter->getImage(job.angle, job.magnitude, job.flowImage);
+        if (terminalParser.opticalFlowData.displayFlow) {
+            opticalFlowVideoWriter->getFrame(job.flowImage, job.flowFrame);
+        }
+        if (terminalParser.opticalFlowData.needVideo) {
+            rectangle(job.image, job.roi, Scalar(0,255,0), 2);
+        }
+    };
+    /// COLORIZE STAGE
+    
+    
+    /// WRITE STAGE
+    // Runs on main thread in frame order
+    auto writeStage = [&](FrameJob& job) {
+        // Write normalized histogram to csv file
+        histogramFile.write(job.histogram);
+        timeFileWriter.write(job.timeStamp);
+        if (qualityFile && qualityScheduler) {
+            qualityFile->write(job.quality);
         }
-
-
         
-
-        // If we read more than one frame
-        if (f > 1) {
-            // For writing FLO
-            if (floFile) {
-                if(f == floFile->getFrameNumber()){
-                    floFile->write(dataBoxes[selected]->angle, dataBoxes[selected]->magnitude);
-                }
+        // For writing FLO
+        if (floFile) {
+            if(job.frame == floFile->getFrameNumber()){
+                floFile->write(job.angle, job.magnitude);
             }
+        }
 
-            // For writing optical flow video
-            if (terminalParser.opticalFlowData.needVideo) {
-                if(opticalFlowVideoWriter){
-                    opticalFlowVideoWriter->write(dataBoxes[selected]->angle, dataBoxes[selected]->magnitude);
-                } else {
-                    printErrorHeader(__LINE__);
-                    cerr << "No video writer for optical flow!" << endl;
-                    printErrorFooter();
-
-                }
-                if (videoWriter) {
-                    Mat image = dataBoxes[selected]->frame.clone();
-                    rectangle(image, *dataBoxes[selected]->roi.get(), Scalar(0,255,0), 2);
-                    videoWriter->write(image);
-                } else {
-                    printErrorHeader(__LINE__);
-                    cerr << "No video writer for normal video!" << endl;
-                    printErrorFooter();
+        // For writing optical flow video
+        if (terminalParser.opticalFlowData.needVideo) {
+            opticalFlowVideoWriter->writeImage(job.flowImage);
+            videoWriter->write(job.image);
+        }
 
-                }
-               
+        if (terminalParser.opticalFlowData.displayFlow) {
+            if (constructDisplayWindowFlow) {
+                namedWindow(DISPLAY_WINDOW_FLOW, WINDOW_NORMAL);
+                constructDisplayWindowFlow = false;
+                changeDisplayWindowImageFlow = true;
             }
-
-            if (terminalParser.opticalFlowData.displayFlow) {
-                if (constructDisplayWindowFlow) {
-                    namedWindow(DISPLAY_WINDOW_FLOW, WINDOW_NORMAL);
-                    constructDisplayWindowFlow = false;
-                    changeDisplayWindowImageFlow = true;
-                }
-                if (changeDisplayWindowImageFlow) {
-                    if(opticalFlowVideoWriter){
-                        opticalFlowVideoWriter->getImage(dataBoxes[selected]->angle, dataBoxes[selected]->magnitude, opticalFlowImage);
-                        opticalFlowVideoWriter->getFrame(opticalFlowImage, opticalFlowFrame);
-                    } else{
-                        opticalFlowFrame = Mat::zeros(dataBoxes[selected]->videoSize, CV_8UC3);
-                        printErrorHeader(__LINE__);
-                        cerr << "No optical flow video writer!" << endl;
-                        cerr << "Output image on DISPLAY WINDOW will be empty!" << endl;
-                    }
-                    
-                    imshow(DISPLAY_WINDOW_FLOW, opticalFlowFrame);
-                    int key = waitKey(1);
-                    switch ((char) key) {
-                        case 'q':
-                            cout << endl;
-                            cout << "You wanted to exit. Exiting..." << endl;
-                            exit(EXIT_SUCCESS);
-                            break;
-                        case 'w':
-                            cout << endl;
-                            cout << "You don't want output to be shown..." << endl;
-                            destroyWindow(DISPLAY_WINDOW_FLOW);
-                            changeDisplayWindowImageFlow = false;
-                            break;
-                    }
+            if (changeDisplayWindowImageFlow) {
+                imshow(DISPLAY_WINDOW_FLOW, job.flowFrame);
+                int key = waitKey(1);
+                switch ((char) key) {
+                    case 'q':
+                        cout << endl;
+                        cout << "You wanted to exit. Exiting..." << endl;
+                        exit(EXIT_SUCCESS);
+                        break;
+                    case 'w':
+                        cout << endl;
+                        cout << "You don't want output to be shown..." << endl;
+                        destroyWindow(DISPLAY_WINDOW_FLOW);
+                        changeDisplayWindowImageFlow = false;
+                        break;
                 }
             }
         }
-        
-        
-        // Clear all vectors!!!
-        selected = -1;
-        metricCenters.clear();
-        normalizedHistogram.clear();
-        amplitudeHistogram.clear();
-        angleHistogram.clear();
-
+    };
+    /// WRITE STAGE
+    
+    
+    /// PIPELINE
+    const PipelineData& pipelineData = terminalParser.pipelineData;
+    Pipeline<FrameJob> pipeline(pipelineData.queueSize, updateStage);
+    if (flowThreads > 1) {
+        pipeline.addWorkerStage("flow", flowStage, flowThreads);
+    }
+    pipeline.addStage("descriptor", descriptorStage, pipelineData.descriptorThreads);
+    if (needFlowImage) {
+        pipeline.addStage("colorize", colorizeStage, pipelineData.colorizeThreads);
+    }
+    pipeline.addStage("write", writeStage);
+    
+    try {
+        pipeline.run();
+    } catch (std::exception& e) {
+        printErrorHeader(__LINE__);
+        cerr << e.what() << endl;
+        printErrorFooter();
     }
+    /// PIPELINE
 
 
     cout << endl;
@@ -190,9 +190,12 @@ void PD_flow_opencv::freeGPUMemory() {
 void PD_flow_opencv::initializeCUDA() {
     //Read one image to know the image resolution
     intensity1 = cv::imread(intensity_filename_1, CV_LOAD_IMAGE_GRAYSCALE);
+    initializeCUDA(intensity1.size());
+}
 
-    width = intensity1.cols;
-    height = intensity1.rows;
+void PD_flow_opencv::initializeCUDA(const cv::Size& imageSize) {
+    width = imageSize.width;
+    height = imageSize.height;
     if (height == 240) {
         cam_mode = 2;
     } else {
@@ -234,8 +237,6 @@ void PD_flow_opencv::showImages() {
 }
 
 bool PD_flow_opencv::loadRGBDFrames() {
-    cv::Mat depth_float;
-
     //First intensity image
     intensity1 = cv::imread(intensity_filename_1, CV_LOAD_IMAGE_GRAYSCALE);
     if (intensity1.empty()) {
@@ -243,10 +244,6 @@ bool PD_flow_opencv::loadRGBDFrames() {
         return 0;
     }
 
-    for (unsigned int u = 0; u < width; u++)
-        for (unsigned int v = 0; v < height; v++)
-            I[v + u * height] = float(intensity1.at<unsigned char>(v, u));
-
     //First depth image
     depth1 = cv::imread(depth_filename_1, -1);
     if (depth1.empty()) {
@@ -254,6 +251,55 @@ bool PD_flow_opencv::loadRGBDFrames() {
         return 0;
     }
 
+    //Second intensity image
+    intensity2 = cv::imread(intensity_filename_2, CV_LOAD_IMAGE_GRAYSCALE);
+    if (intensity2.empty()) {
+        printf("\nThe second intensity image (%s) cannot be found, please check that it is in the correct folder \n", intensity_filename_2);
+        return 0;
+    }
+
+    //Second depth image
+    depth2 = cv::imread(depth_filename_2, -1);
+    if (depth2.empty()) {
+        printf("\nThe second depth image (%s) cannot be found, please check that they are in the correct folder \n", depth_filename_2);
+        return 0;
+    }
+
+    return loadRGBDFrames(intensity1, depth1, intensity2, depth2);
+}
+
+bool PD_flow_opencv::loadRGBDFrames(const cv::Mat& intensity1, const cv::Mat& depth1,
+        const cv::Mat& intensity2, const cv::Mat& depth2) {
+    
+    if (intensity1.empty() || depth1.empty() || intensity2.empty() || depth2.empty()) {
+        printf("\nRGBD frames are empty \n");
+        return 0;
+    }
+    if (intensity1.type() != CV_8UC1 || intensity2.type() != CV_8UC1) {
+        printf("\nIntensity images must be grayscale \n");
+        return 0;
+    }
+    cv::Size imageSize(width, height);
+    if (intensity1.size() != imageSize || depth1.size() != imageSize ||
+            intensity2.size() != imageSize || depth2.size() != imageSize) {
+        printf("\nRGBD frames must be of size given to initializeCUDA() \n");
+        return 0;
+    }
+    
+    // Headers only, for showImages()
+    this->intensity1 = intensity1;
+    this->depth1 = depth1;
+    this->intensity2 = intensity2;
+    this->depth2 = depth2;
+    
+    cv::Mat depth_float;
+
+    //First intensity image
+    for (unsigned int u = 0; u < width; u++)
+        for (unsigned int v = 0; v < height; v++)
+            I[v + u * height] = float(intensity1.at<unsigned char>(v, u));
+
+    //First depth image
     //depth1.convertTo(depth_float, CV_32FC1, 1.0 / 5000.0);
     depth1.convertTo(depth_float, CV_32FC1, 1.0 / 1000.0); // provide data in meters
     for (unsigned int v = 0; v < height; v++)
@@ -264,22 +310,11 @@ bool PD_flow_opencv::loadRGBDFrames() {
 
 
     //Second intensity image
-    intensity2 = cv::imread(intensity_filename_2, CV_LOAD_IMAGE_GRAYSCALE);
-    if (intensity2.empty()) {
-        printf("\nThe second intensity image (%s) cannot be found, please check that it is in the correct folder \n", intensity_filename_2);
-        return 0;
-    }
-
     for (unsigned int v = 0; v < height; v++)
         for (unsigned int u = 0; u < width; u++)
             I[v + u * height] = float(intensity2.at<unsigned char>(v, u));
 
     //Second depth image
-    depth2 = cv::imread(depth_filename_2, -1);
-    if (depth2.empty()) {
-        printf("\nThe second depth image (%s) cannot be found, please check that they are in the correct folder \n", depth_filename_2);
-        return 0;
-    }
     //depth2.convertTo(depth_float, CV_32FC1, 1.0 / 5000.0);
     depth2.convertTo(depth_float, CV_32FC1, 1.0 / 1000.0); // provide data in meters
     for (unsigned int v = 0; v < height; v++) {
@@ -102,10 +102,14 @@ public:
 
 	//Methods
 	bool loadRGBDFrames();
+    // Same as loadRGBDFrames() for decoded gray intensity and 16-bit depth
+    bool loadRGBDFrames(const cv::Mat& intensity1, const cv::Mat& depth1,
+            const cv::Mat& intensity2, const cv::Mat& depth2);
     void createImagePyramidGPU();
     void solveSceneFlowGPU();
     void freeGPUMemory();
     void initializeCUDA();
+    void initializeCUDA(const cv::Size& imageSize);
 	void showImages();
     cv::Mat createImage() const;
     void saveResults( const cv::Mat& image, const unsigned int& image_count );
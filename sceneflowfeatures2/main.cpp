@@ -32,12 +32,15 @@
 #include "sf2terminalparser.hpp"
 #include "opticalflowvideo.hpp"
 #include "selectorfile.hpp"
+#include "selectionplanfile.hpp"
 #include "cameraselector.hpp"
 #include "timefilewriter.hpp"
 
 #include "sf2databox.hpp"
 #include "basetimer.hpp"
 #include "flofile.hpp"
+#include "threadpool.hpp"
+#include "executor.hpp"
 #include "config.hpp"
 
 using namespace std;
@@ -83,6 +86,10 @@ int main(int argc, char** argv) {
 
 
     /// DESCRIPTORS
+    // Histogram loops use chosen instruction set
+    HistogramKernels::setIsa(terminalParser.descriptorIsa);
+    cout << "Descriptor ISA: " << HistogramKernels::getName(HistogramKernels::getIsa()) << endl;
+
     // Get descriptors
     std::shared_ptr<gk::AmplitudeDescriptor> amplitudeDescriptor = NULL;
     if (terminalParser.amplitudeDescriptorData.binCount > 0) {
@@ -109,19 +116,42 @@ int main(int argc, char** argv) {
 
 
     /// CAMERA SELECTOR
-    SelectorFile selectorFile(terminalParser.cameraSelectorFilename);
-    CameraSelectorData data;
+    // Precomputed plan or selection from metric centers
+    std::shared_ptr<gk::SelectionPlan> selectionPlan = NULL;
+    std::shared_ptr<gk::CameraSelector> cameraSelector = NULL;
     try {
-        data = selectorFile.getNext();
+        if (!terminalParser.selectionPlanFilename.empty()) {
+            SelectionPlanFileReader planFile(terminalParser.selectionPlanFilename);
+            selectionPlan = std::make_shared<SelectionPlan>(planFile.getNext());
+            
+        } else {
+            SelectorFile selectorFile(terminalParser.cameraSelectorFilename);
+            cameraSelector = std::make_shared<CameraSelector>(selectorFile.getNext());
+        }
     } catch (std::exception& e) {
         printErrorHeader(__LINE__);
         cerr << e.what() << endl;
         printErrorFooter();
 
     }
-    CameraSelector cameraSelector(data);
     /// CAMERA SELECTOR
 
+    
+    /// FRAME RANGE
+    // Last frame with flow, -1 for end of sequence. Flow of f-th loop is 
+    // synced with (N+1)-th frame.
+    long lastFrame = -1;
+    if (selectionPlan) {
+        lastFrame = selectionPlan->getLastFrame();
+        if (!selectionPlan->contains(std::max(terminalParser.startFrame, 1) + 1)) {
+            printErrorHeader(__LINE__);
+            cerr << "Selection plan has no frame after start frame " 
+                    << terminalParser.startFrame << "." << endl;
+            printErrorFooter();
+        }
+    }
+    /// FRAME RANGE
+
 
 
 
@@ -149,13 +179,29 @@ int main(int argc, char** argv) {
                 terminalParser.intrinsicFilenames[i],
                 terminalParser.extrinsicFilenames[i],
                 terminalParser.startFrame,
-                terminalParser.sceneFlowData);
+                terminalParser.sceneFlowData,
+                selectionPlan,
+                i);
 
         dataBoxes.push_back(dataBox);
     }
     /// CONTAINERS
 
 
+    /// CAMERA THREADS
+    // Cameras are independent until selection, main thread updates one too
+    int cameraThreads = terminalParser.sceneFlowData.cameraThreads;
+    if (cameraThreads < 0) {
+        cameraThreads = (int) dataBoxes.size() - 1;
+    }
+    // Main thread is worker 0
+    Executor executor(terminalParser.executorData, 0, cameraThreads);
+    ThreadPool& cameraPool = executor.getCameraPool();
+    executor.pinCameraThread();
+    executor.printSplit();
+    /// CAMERA THREADS
+
+
     /// [Main loop Config]
     Mat normalizedAngle;
     /// [Main loop config]
@@ -171,6 +217,8 @@ int main(int argc, char** argv) {
     
     int selected = -1;
     vector<Point3d> metricCenters;
+    // Not vector<bool>, cameras write it from different threads
+    vector<char> updated(dataBoxes.size());
     
     
     BaseTimer timer(1.0);
@@ -180,15 +228,48 @@ int main(int argc, char** argv) {
     /// [Main loop]
     // Start f for second sequence (from image 1,2,3... instead of 0,1,2,...)
     for (int f = terminalParser.startFrame;; f++) {
+        if (lastFrame >= 0 && std::max(f, 1) + 1 > lastFrame) {
+            break;
+        }
 
         // Get next filenames and times
+        try {
+            cameraPool.run(dataBoxes.size(), [&](size_t i) {
+                updated[i] = dataBoxes[i]->update();
+            });
+        } catch (std::exception& e) {
+            printErrorHeader(__LINE__);
+            cerr << e.what() << endl;
+            printErrorFooter();
+        }
+        
+        // Sequence of any camera ended, writers are closed when main returns
+        bool sequenceEnd = false;
+        for (size_t i = 0; i < dataBoxes.size(); i++) {
+            if (!updated[i]) {
+                cout << endl;
+                cout << "Second BGR image not found." << endl;
+                cout << "Last file: " << dataBoxes[i]->imageFilenames[0] << endl;
+                sequenceEnd = true;
+            }
+        }
+        if (sequenceEnd) {
+            break;
+        }
         for (auto dataBox : dataBoxes) {
-            dataBox->update();
             metricCenters.push_back(dataBox->metricCenter);
         }
 
-        selected = cameraSelector.select(metricCenters);
+        if (selectionPlan) {
+            // Selection is synced with (N+1)-th frame
+            selected = selectionPlan->getSelected(std::max(f, 1) + 1);
+        } else {
+            selected = cameraSelector->select(metricCenters);
+        }
         metricCenters.clear();
+        
+        // Scene flow only for selected camera
+        dataBoxes[selected]->calculateFlow();
 
 
         // Init video writer
@@ -298,7 +379,7 @@ int main(int argc, char** argv) {
     }
     /// [Main loop]
 
-
+    cout << "EXIT SUCCESS." << endl;
     return 0;
 }
 
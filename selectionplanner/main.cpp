@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// std
+#include <iostream>
+#include <string>
+#include <memory>
+
+// local
+#include "planterminalparser.hpp"
+#include "selectorfile.hpp"
+#include "selectionplanfile.hpp"
+#include "selectionplanner.hpp"
+#include "config.hpp"
+
+using namespace std;
+using namespace gk;
+
+static void printErrorHeader(int line) {
+    cerr << endl;
+    cerr << "File: " << __FILE__ << " line: " << line << endl;
+}
+
+static void printErrorFooter() {
+    cerr << "Aborting program..." << endl;
+    cerr << endl;
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv) {
+
+    /// TERMINAL PARSER
+    PlanTerminalParser terminalParser = PlanTerminalParser(argc, const_cast<const char**> (argv), VERSION_MAJOR, VERSION_MINOR);
+    try {
+        terminalParser.parseInput();
+    } catch (std::exception& e) {
+        printErrorHeader(__LINE__);
+        cerr << e.what() << endl;
+        printErrorFooter();
+    }
+    /// TERMINAL PARSER
+
+
+    /// PLAN
+    // Same selection as feature binaries make while calculating flow
+    try {
+        SelectorFile selectorFile(terminalParser.cameraSelectorFilename);
+        SelectionPlanner planner(terminalParser.depthFilenames,
+                terminalParser.trackerFilenames,
+                terminalParser.intrinsicFilenames,
+                terminalParser.extrinsicFilenames,
+                selectorFile.getNext(),
+                terminalParser.startFrame,
+                terminalParser.sceneFlowTracker,
+                terminalParser.prefetchDepth,
+                terminalParser.prefetchThreads);
+
+        cout << "=======================" << endl;
+        cout << "Planning camera selection..." << endl;
+        SelectionPlan plan = planner.plan(terminalParser.frameCount);
+
+        SelectionPlanFileWriter planFile(terminalParser.outPlanFilename);
+        if (!planFile.write(plan)) {
+            throw Exception(__FILE__, __LINE__, "Could not write selection plan " + terminalParser.outPlanFilename);
+        }
+        cout << "Planned frames: " << plan.getFrameCount() << endl;
+        
+    } catch (std::exception& e) {
+        printErrorHeader(__LINE__);
+        cerr << e.what() << endl;
+        printErrorFooter();
+    }
+    /// PLAN
+
+    return 0;
+}
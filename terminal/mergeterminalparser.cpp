@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mergeterminalparser.hpp"
+
+using namespace gk;
+
+MergeTerminalParser::MergeTerminalParser(int argc, const char** argv, int majorVersion, int minorVersion)
+: AbstractTerminalParser(majorVersion, minorVersion), description("Allowed options") {
+
+    description.add_options()
+            //
+            // help
+            ("help,h", "Produce help message")
+            //
+            // files
+            ("files", value< vector<string> >()->multitoken(), "Output files of shards, e.g. --out-hist and --out-time, without shard suffix")
+            ("shard-count", value<int>(), "Number of shards")
+            ;
+    store(parse_command_line(argc, argv, description), parseMap);
+    notify(parseMap);
+}
+
+void MergeTerminalParser::parseInput() {
+    parseHelp();
+
+    parseFiles();
+}
+
+void MergeTerminalParser::parseHelp() {
+    if (parseMap.count("help")) {
+        cout << endl;
+        cout << "Version " << majorVersion << "." << minorVersion << endl;
+        cout << description << endl;
+        exit(EXIT_SUCCESS);
+    }
+}
+
+void MergeTerminalParser::parseFiles() {
+    if (parseMap.count("files")) {
+        filenames = expandNames(parseMap["files"].as< vector<string> >());
+
+    } else {
+        throw InvalidInputException(__FILE__, __LINE__, "--files");
+    }
+    if (parseMap.count("shard-count")) {
+        shardCount = parseMap["shard-count"].as<int>();
+
+    } else {
+        throw InvalidInputException(__FILE__, __LINE__, "--shard-count");
+    }
+    if (shardCount < 1) {
+        throw Exception(__FILE__, __LINE__, "--shard-count must be positive.");
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MERGETERMINALPARSER_HPP
+#define MERGETERMINALPARSER_HPP
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <boost/program_options.hpp>
+
+#include "abstractterminalparser.hpp"
+#include "exception.hpp"
+
+using namespace std;
+using namespace boost::program_options;
+
+namespace gk{
+    
+    class MergeTerminalParser : public AbstractTerminalParser {
+    private:
+        options_description description;
+        variables_map parseMap;
+        
+        void parseHelp() override;
+        void parseFiles();
+        
+    public:
+        // Output filenames as given to feature binary, without shard suffix
+        vector<string> filenames;
+        int shardCount;
+        
+        MergeTerminalParser(int argc, const char** argv, int majorVersion, int minorVersion);
+        void parseInput() override;
+    };
+}
+
+#endif /* MERGETERMINALPARSER_HPP */
+
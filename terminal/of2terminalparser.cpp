@@ -39,12 +39,14 @@ gk::OF2TerminalParser::OF2TerminalParser(int argc, const char ** argv, int major
             ("diag-files", value< vector<string> >()->multitoken(), "Diagonal files")
             ("depth-files", value< vector<string> >()->multitoken(), "Sequence path for depth files")
             ("selector-file", value< string >(), "Camera selector config file")
+            ("selection-plan", value< string >(), "Precomputed camera selection plan. Replaces --selector-file, so depth is not loaded for selection.")
             //
             // out
             ("flo-file", value<string>(), "Filename for FLO file")
             ("flo-frame", value<long>(), "Frame number for FLO file")
             ("out-hist", value<string>(), "Filename for histogram features.")
             ("out-time", value<string>(), "Filename for merged time stamps.")
+            ("out-quality", value<string>(), "Filename for flow quality of every histogram, needed with --target-fps.")
             //
             // tracker data
             ("tracker-scale", value<float>()->default_value(0), "Scale for tracker ROI")
@@ -53,7 +55,13 @@ gk::OF2TerminalParser::OF2TerminalParser(int argc, const char ** argv, int major
             //
             // optical flow data
             ("start-frame", value<long>()->default_value(1), "Start frame for video")
-            ("of-algorithm", value<int>()->default_value(0), "Optical flow algorithm. Default(Farneback)")
+            ("decode-depth", value<int>()->default_value(2), "Frames decoded ahead on background thread. If 0 frames are decoded synchronously.")
+            ("prefetch-depth", value<int>()->default_value(4), "Depth images decoded ahead on background threads. If 0 they are decoded synchronously.")
+            ("prefetch-threads", value<int>()->default_value(1), "Threads decoding depth images of every camera")
+            ("luma-decode", value<bool>()->default_value(true), "Convert frames to gray on decoding thread and keep color only for --of-video")
+            ("of-algorithm", value<string>()->default_value("farneback"),
+            "Optical flow algorithm: farneback (0), lucas-kanade (1), native-farneback (2) or dis (3). "
+            "native-farneback reuses expansion of previous frame, with --roi-flow only while padded ROI doesn't move.")
             ("display-flow", value<bool>()->default_value(false), "Display flow during calculation")
             ("pyramid-scale,ps", value<float>()->default_value(0.5), "Pyramid scale")
             ("pyramid-layers,pl", value<int>()->default_value(3), "Pyramid layers")
@@ -62,6 +70,17 @@ gk::OF2TerminalParser::OF2TerminalParser(int argc, const char ** argv, int major
             ("neighbour-size,ns", value<int>()->default_value(5), "Size of the pixel neighbourhood")
             ("sigma,gd", value<float>()->default_value(1.2f), "Standard deviation of the gaussian")
             ("operation-flags,op", value<int>()->default_value(0), "Operation flags for of algorithm")
+            ("lk-max-points", value<int>()->default_value(400), "Max points tracked by Lucas-Kanade per frame")
+            ("lk-corners", value<bool>()->default_value(false), "Lucas-Kanade tracks corners instead of regular grid")
+            ("roi-flow", value<bool>()->default_value(false), "Calculate optical flow only on padded tracker ROI")
+            ("roi-max-displacement", value<int>()->default_value(16), "With --roi-flow largest expected displacement in pixels, part of ROI padding")
+            ("canonical-diagonal", value<int>()->default_value(0), "With --roi-flow resize ROI to this diagonal in pixels before flow. If 0 native size is used.")
+            ("shared-pyramid", value<bool>()->default_value(false), "Build frame pyramid once and reuse it for next frame pair (Farneback)")
+            ("fused-histogram", value<bool>()->default_value(false), "Calculate both histograms in one pass over Cartesian flow")
+            ("target-fps", value<double>()->default_value(0), "Lower Farneback quality when needed to hold this fps. If 0 quality is fixed.")
+            ("min-iterations", value<int>()->default_value(1), "Lowest iterations with --target-fps")
+            ("min-pyramid-layers", value<int>()->default_value(1), "Lowest pyramid layers with --target-fps")
+            ("min-window-size", value<int>()->default_value(5), "Lowest averaging window size with --target-fps")
             ("of-video", value<string>(), "Output optical flow video")
             //
             // angle descriptor data
@@ -79,7 +98,32 @@ gk::OF2TerminalParser::OF2TerminalParser(int argc, const char ** argv, int major
             "for large displacements set this < 1 to prevent clipping, for now should be 1.0")
             ("ad-max-norm", value<float>()->default_value(0.0),
             "For determining max norm range. If 0 norm will not be used.")
+            ("descriptor-isa", value<string>()->default_value("auto"),
+            "Instruction set for descriptor histograms: auto, scalar, sse4.2, avx2 or avx512")
+            //
+            // pipeline data
+            ("queue-size", value<int>()->default_value(8), "Frames waiting between two pipeline stages")
+            ("flow-threads", value<int>()->default_value(1), "Threads calculating flow of frame pairs. If 1 flow is calculated while reading cameras.")
+            ("descriptor-threads", value<int>()->default_value(2), "Threads calculating histograms")
+            ("colorize-threads", value<int>()->default_value(2), "Threads colorizing flow for --of-video and --display-flow")
+            ("camera-threads", value<int>()->default_value(-1), "Extra threads updating cameras in parallel. If -1 every camera gets own thread.")
+            //
+            // executor data
+            ("threads", value<int>()->default_value(0), "Cores shared by flow workers and OpenCV. If 0 all cores are used.")
+            ("opencv-threads", value<int>()->default_value(-1), "Threads of OpenCV pool, shared by all workers. If -1 all cores with one worker and 1 with more.")
+            ("pin-threads", value<bool>()->default_value(false), "Pin every flow worker to own slice of cores")
+            //
+            // shard data
+            ("shard-count", value<int>()->default_value(1), "Split frames of --selection-plan to this many shards, each run by own process")
+            ("shard-index", value<int>()->default_value(0), "Shard calculated by this process, from 0. Outputs get suffix .shard<index>.")
             ;
+#ifdef OPTICAL_FLOW_DIS
+    description.add_options()
+            ("dis-preset", value<string>()->default_value("fast"), "DIS preset: ultrafast, fast or medium")
+            ("dis-patch-size", value<int>()->default_value(0), "DIS patch size. If 0 preset is used.")
+            ("dis-patch-stride", value<int>()->default_value(0), "DIS patch stride. If 0 preset is used.")
+            ;
+#endif
     store(parse_command_line(argc, argv, description), parseMap);
     notify(parseMap);
 }
@@ -92,7 +136,11 @@ void OF2TerminalParser::parseInput() {
     parseOpticalFlowData();
     parseAngleDescriptor();
     parseAmplitudeDescriptor();
+    parseDescriptorIsa();
+    parsePipelineData();
+    parseExecutorData();
     parseCameraSelectorData();
+    parseShardData();
 }
 
 void OF2TerminalParser::parseHelp() {
@@ -161,6 +209,9 @@ void OF2TerminalParser::parseFiles() {
     } else {
         throw InvalidInputException(__FILE__, __LINE__, "--out-time");
     }
+    if (parseMap.count("out-quality")) {
+        outQualityFilename = expandName(parseMap["out-quality"].as< string >());
+    }
     if (parseMap.count("flo-file")) {
         floFilename = expandName(parseMap["flo-file"].as< string >());
         
@@ -215,7 +266,17 @@ void OF2TerminalParser::parseTrackerData() {
 void OF2TerminalParser::parseOpticalFlowData() {
     opticalFlowData.startFrame = parseMap["start-frame"].as<long>();
     startFrame = opticalFlowData.startFrame;
-    opticalFlowData.flowType = static_cast<OpticalFlowType> (parseMap["of-algorithm"].as<int>());
+    opticalFlowData.decodeDepth = parseMap["decode-depth"].as<int>();
+    if (opticalFlowData.decodeDepth < 0) {
+        throw Exception(__FILE__, __LINE__, "--decode-depth can't be negative.");
+    }
+    opticalFlowData.prefetchDepth = parseMap["prefetch-depth"].as<int>();
+    opticalFlowData.prefetchThreads = parseMap["prefetch-threads"].as<int>();
+    if (opticalFlowData.prefetchDepth < 0 || opticalFlowData.prefetchThreads < 1) {
+        string message = "--prefetch-depth can't be negative and --prefetch-threads must be positive.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    opticalFlowData.flowType = parseFlowType(parseMap["of-algorithm"].as<string>());
     opticalFlowData.displayFlow = parseMap["display-flow"].as<bool>();
     opticalFlowData.pyramidScale = parseMap["pyramid-scale"].as<float>();
     opticalFlowData.pyramidLayers = parseMap["pyramid-layers"].as<int>();
@@ -224,6 +285,43 @@ void OF2TerminalParser::parseOpticalFlowData() {
     opticalFlowData.neighbourSize = parseMap["neighbour-size"].as<int>();
     opticalFlowData.gaussianDeviation = parseMap["sigma"].as<float>();
     opticalFlowData.operationFlags = parseMap["operation-flags"].as<int>();
+#ifdef OPTICAL_FLOW_DIS
+    opticalFlowData.disPreset = parseDisPreset(parseMap["dis-preset"].as<string>());
+    opticalFlowData.disPatchSize = parseMap["dis-patch-size"].as<int>();
+    opticalFlowData.disPatchStride = parseMap["dis-patch-stride"].as<int>();
+#else
+    opticalFlowData.disPreset = 0;
+    opticalFlowData.disPatchSize = 0;
+    opticalFlowData.disPatchStride = 0;
+#endif
+    opticalFlowData.lkMaxPoints = parseMap["lk-max-points"].as<int>();
+    opticalFlowData.lkCorners = parseMap["lk-corners"].as<bool>();
+    opticalFlowData.roiFlow = parseMap["roi-flow"].as<bool>();
+    opticalFlowData.roiMaxDisplacement = parseMap["roi-max-displacement"].as<int>();
+    opticalFlowData.canonicalDiagonal = parseMap["canonical-diagonal"].as<int>();
+    opticalFlowData.sharedPyramid = parseMap["shared-pyramid"].as<bool>();
+    opticalFlowData.fusedHistogram = parseMap["fused-histogram"].as<bool>();
+    if (opticalFlowData.sharedPyramid && 
+            (opticalFlowData.roiFlow || opticalFlowData.flowType != FARNEBACK)) {
+        string message = "--shared-pyramid works only with Farneback on whole frame.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    opticalFlowData.targetFps = parseMap["target-fps"].as<double>();
+    opticalFlowData.minQuality.iterationsCount = parseMap["min-iterations"].as<int>();
+    opticalFlowData.minQuality.pyramidLayers = parseMap["min-pyramid-layers"].as<int>();
+    opticalFlowData.minQuality.windowSize = parseMap["min-window-size"].as<int>();
+    if (opticalFlowData.targetFps > 0) {
+        parseQualityBounds();
+    }
+    if (opticalFlowData.roiMaxDisplacement < 0) {
+        string message = "--roi-max-displacement can't be negative.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    if (opticalFlowData.canonicalDiagonal < 0 || 
+            (opticalFlowData.canonicalDiagonal > 0 && !opticalFlowData.roiFlow)) {
+        string message = "--canonical-diagonal must be positive and needs --roi-flow.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
     if (parseMap.count("of-video")) {
         opticalFlowData.outFlowVideo = expandName(parseMap["of-video"].as<string>()) + "-of.avi";
         opticalFlowData.outVideo = expandName(parseMap["of-video"].as<string>()) + ".avi";
@@ -231,8 +329,79 @@ void OF2TerminalParser::parseOpticalFlowData() {
     } else {
         opticalFlowData.needVideo = false;
     }
+    // Output video draws ROI on color frame
+    opticalFlowData.lumaDecode = parseMap["luma-decode"].as<bool>() && 
+            !opticalFlowData.needVideo;
+    // Sparse flow has no image to show or write
+    if (opticalFlowData.flowType == LUCAS_KANADE && 
+            (opticalFlowData.needVideo || opticalFlowData.displayFlow || !floFilename.empty())) {
+        string message = "Lucas-Kanade can't be used with --of-video, --display-flow or --flo-file.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    // Fused histogram doesn't keep polar flow
+    if (opticalFlowData.fusedHistogram && (opticalFlowData.flowType == LUCAS_KANADE ||
+            opticalFlowData.needVideo || opticalFlowData.displayFlow || !floFilename.empty())) {
+        string message = "--fused-histogram can't be used with Lucas-Kanade, "
+                "--of-video, --display-flow or --flo-file.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+}
+
+void OF2TerminalParser::parseQualityBounds() {
+    if (opticalFlowData.flowType != FARNEBACK && opticalFlowData.flowType != NATIVE_FARNEBACK) {
+        string message = "--target-fps works only with farneback or native-farneback.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    if (opticalFlowData.sharedPyramid) {
+        string message = "--target-fps can't be used with --shared-pyramid.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    if (outQualityFilename.empty()) {
+        throw InvalidInputException(__FILE__, __LINE__, "--out-quality");
+    }
+    
+    const FlowQuality& minQuality = opticalFlowData.minQuality;
+    if (minQuality.iterationsCount < 1 || minQuality.pyramidLayers < 1 || 
+            minQuality.windowSize < 1 ||
+            minQuality.iterationsCount > opticalFlowData.iterationsCount ||
+            minQuality.pyramidLayers > opticalFlowData.pyramidLayers ||
+            minQuality.windowSize > opticalFlowData.windowSize) {
+        string message = "--min-iterations, --min-pyramid-layers and --min-window-size "
+                "must be positive and not above --iterations, --pyramid-layers and --window-size.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
 }
 
+OpticalFlowType OF2TerminalParser::parseFlowType(const string& name) {
+    if (name == "farneback" || name == "0") {
+        return FARNEBACK;
+    } else if (name == "lucas-kanade" || name == "1") {
+        return LUCAS_KANADE;
+    } else if (name == "native-farneback" || name == "2") {
+        return NATIVE_FARNEBACK;
+    } else if (name == "dis" || name == "3") {
+#ifdef OPTICAL_FLOW_DIS
+        return DIS;
+#else
+        throw Exception(__FILE__, __LINE__, "DIS optical flow needs OpenCV 3.2 or newer.");
+#endif
+    }
+    throw Exception(__FILE__, __LINE__, "Unknown optical flow algorithm: " + name);
+}
+
+#ifdef OPTICAL_FLOW_DIS
+int OF2TerminalParser::parseDisPreset(const string& name) {
+    if (name == "ultrafast") {
+        return optflow::DISOpticalFlow::PRESET_ULTRAFAST;
+    } else if (name == "fast") {
+        return optflow::DISOpticalFlow::PRESET_FAST;
+    } else if (name == "medium") {
+        return optflow::DISOpticalFlow::PRESET_MEDIUM;
+    }
+    throw Exception(__FILE__, __LINE__, "Unknown DIS preset: " + name);
+}
+#endif
+
 void OF2TerminalParser::parseAngleDescriptor() {
 
     angleDescriptorData.binCount = parseMap["hd-b"].as<int>();
@@ -248,8 +417,57 @@ void OF2TerminalParser::parseAmplitudeDescriptor() {
     amplitudeDescriptorData.maxNorm = parseMap["ad-max-norm"].as<float>();
 }
 
+void OF2TerminalParser::parseDescriptorIsa() {
+    descriptorIsa = HistogramKernels::fromName(parseMap["descriptor-isa"].as<string>());
+    if (!HistogramKernels::isSupported(descriptorIsa)) {
+        string message = "--descriptor-isa " + HistogramKernels::getName(descriptorIsa) 
+                + " is not supported by this CPU.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+}
+
+void OF2TerminalParser::parsePipelineData() {
+    pipelineData.queueSize = parseMap["queue-size"].as<int>();
+    pipelineData.descriptorThreads = parseMap["descriptor-threads"].as<int>();
+    pipelineData.colorizeThreads = parseMap["colorize-threads"].as<int>();
+    pipelineData.flowThreads = parseMap["flow-threads"].as<int>();
+    pipelineData.cameraThreads = parseMap["camera-threads"].as<int>();
+    if (pipelineData.queueSize < 1 || pipelineData.descriptorThreads < 1 || 
+            pipelineData.colorizeThreads < 1 || pipelineData.flowThreads < 1) {
+        string message = "--queue-size, --flow-threads, --descriptor-threads and "
+                "--colorize-threads must be positive.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    // Shared pyramid carries state from one frame pair to next. Quality 
+    // scheduler doesn't, every pair takes quality scheduled for it.
+    if (pipelineData.flowThreads > 1 && opticalFlowData.sharedPyramid) {
+        string message = "--flow-threads can't be used with --shared-pyramid.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    if (pipelineData.cameraThreads < -1) {
+        throw Exception(__FILE__, __LINE__, "--camera-threads must be -1 or more.");
+    }
+}
+
+void OF2TerminalParser::parseExecutorData() {
+    executorData.threads = parseMap["threads"].as<int>();
+    executorData.openCvThreads = parseMap["opencv-threads"].as<int>();
+    executorData.pinThreads = parseMap["pin-threads"].as<bool>();
+    if (executorData.threads < 0) {
+        throw Exception(__FILE__, __LINE__, "--threads must be 0 or more.");
+    }
+    if (executorData.openCvThreads == 0 || executorData.openCvThreads < -1) {
+        throw Exception(__FILE__, __LINE__, "--opencv-threads must be -1 or positive.");
+    }
+}
+
 void OF2TerminalParser::parseCameraSelectorData() {
-    if (parseMap.count("selector-file")) {
+    if (parseMap.count("selection-plan")) {
+        selectionPlanFilename = expandName(parseMap["selection-plan"].as< string >());
+#ifdef DEBUG
+        cout << "Selection plan: " << selectionPlanFilename << endl;
+#endif
+    } else if (parseMap.count("selector-file")) {
         cameraSelectorFilename = expandName(parseMap["selector-file"].as< string >());
 #ifdef DEBUG
         cout << "Camera selector file: " << cameraSelectorFilename << endl;
@@ -257,4 +475,31 @@ void OF2TerminalParser::parseCameraSelectorData() {
     } else {
         throw InvalidInputException(__FILE__, __LINE__, "--selector-file");
     }
-}
\ No newline at end of file
+}
+
+void OF2TerminalParser::parseShardData() {
+    shardData.count = parseMap["shard-count"].as<int>();
+    shardData.index = parseMap["shard-index"].as<int>();
+    if (shardData.count < 1 || shardData.index < 0 || shardData.index >= shardData.count) {
+        throw Exception(__FILE__, __LINE__, "--shard-index must be from 0 to --shard-count - 1.");
+    }
+    if (shardData.count == 1) {
+        return;
+    }
+    
+    // Camera selector and quality scheduler depend on previous frames, 
+    // so shard output would differ from serial run
+    if (selectionPlanFilename.empty()) {
+        throw InvalidInputException(__FILE__, __LINE__, "--selection-plan");
+    }
+    if (opticalFlowData.targetFps > 0) {
+        throw Exception(__FILE__, __LINE__, "--target-fps can't be used with shards.");
+    }
+    if (opticalFlowData.needVideo || opticalFlowData.displayFlow || !floFilename.empty()) {
+        string message = "--of-video, --display-flow and --flo-file can't be used with shards.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+    
+    outHistFilename = ShardFiles::getFilename(outHistFilename, shardData.index);
+    outTimeFilename = ShardFiles::getFilename(outTimeFilename, shardData.index);
+}
@@ -30,8 +30,11 @@
 #include "exception.hpp"
 #include "cameraselector.hpp"
 #include "basedescriptor.hpp"
+#include "histogramkernels.hpp"
 #include "opticalflow.hpp"
 #include "of2trackerfile.hpp"
+#include "shardfiles.hpp"
+#include "executor.hpp"
 
 using namespace std;
 using namespace boost::program_options;
@@ -39,7 +42,22 @@ using namespace boost::filesystem;
 
 namespace gk{
     
+    // Queues and threads of frame pipeline
+    struct PipelineData {
+        int queueSize;
+        int descriptorThreads;
+        int colorizeThreads;
+        // Threads calculating flow of frame pairs, each with own flow state
+        int flowThreads;
+        // Threads updating cameras besides pipeline thread, -1 for one per camera
+        int cameraThreads;
+    };
     
+    // Part of recording calculated by this process
+    struct ShardData {
+        int count;
+        int index;
+    };
     
     class OF2TerminalParser : public AbstractTerminalParser {
     private:
@@ -52,7 +70,17 @@ namespace gk{
         void parseOpticalFlowData();
         void parseAngleDescriptor();
         void parseAmplitudeDescriptor();
+        void parseDescriptorIsa();
+        void parsePipelineData();
+        void parseExecutorData();
         void parseCameraSelectorData();
+        void parseShardData();
+        
+        void parseQualityBounds();
+        OpticalFlowType parseFlowType(const string& name);
+#ifdef OPTICAL_FLOW_DIS
+        int parseDisPreset(const string& name);
+#endif
         
         
         
@@ -66,16 +94,23 @@ namespace gk{
         vector<string> depthFilenames;
         
         string cameraSelectorFilename;
+        // If set, camera selector isn't used
+        string selectionPlanFilename;
         string floFilename;
         long floFrameCount;
         string outHistFilename;
         string outTimeFilename;
+        string outQualityFilename;
         
         long startFrame;
         TrackerData trackerData;
         OpticalFlowData opticalFlowData;
         DescriptorData angleDescriptorData;
         DescriptorData amplitudeDescriptorData;
+        KernelIsa descriptorIsa;
+        PipelineData pipelineData;
+        ExecutorData executorData;
+        ShardData shardData;
 
         
         
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "packterminalparser.hpp"
+
+using namespace gk;
+
+PackTerminalParser::PackTerminalParser(int argc, const char** argv, int majorVersion, int minorVersion)
+: AbstractTerminalParser(majorVersion, minorVersion), description("Allowed options") {
+
+    description.add_options()
+            //
+            // help
+            ("help,h", "Produce help message")
+            //
+            // files
+            ("depth-files", value< vector<string> >()->multitoken(), "Sequence path for depth files")
+            ("time-files", value< vector<string> >()->multitoken(), "Time stamps files, embedded in containers")
+            //
+            // out
+            ("out-files", value< vector<string> >()->multitoken(), "Depth containers, one per depth sequence, ending with .depth")
+            //
+            // pack data
+            ("start-frame", value<long>()->default_value(1), "First depth frame to pack")
+            ("frame-count", value<long>()->default_value(-1), "Frames to pack. If -1 until depth images end.")
+            ;
+    store(parse_command_line(argc, argv, description), parseMap);
+    notify(parseMap);
+}
+
+void PackTerminalParser::parseInput() {
+    parseHelp();
+
+    parseFiles();
+    parsePackData();
+}
+
+void PackTerminalParser::parseHelp() {
+    if (parseMap.count("help")) {
+        cout << endl;
+        cout << "Version " << majorVersion << "." << minorVersion << endl;
+        cout << description << endl;
+        exit(EXIT_SUCCESS);
+    }
+}
+
+void PackTerminalParser::parseFiles() {
+    if (parseMap.count("depth-files")) {
+        depthFilenames = expandNames(parseMap["depth-files"].as< vector<string> >());
+
+    } else {
+        throw InvalidInputException(__FILE__, __LINE__, "--depth-files");
+    }
+    if (parseMap.count("time-files")) {
+        timeFilenames = expandNames(parseMap["time-files"].as< vector<string> >());
+        if (timeFilenames.size() != depthFilenames.size()) {
+            throw Exception(__FILE__, __LINE__, "Every depth sequence needs time file.");
+        }
+    }
+    if (parseMap.count("out-files")) {
+        outFilenames = expandNames(parseMap["out-files"].as< vector<string> >());
+
+    } else {
+        throw InvalidInputException(__FILE__, __LINE__, "--out-files");
+    }
+    if (outFilenames.size() != depthFilenames.size()) {
+        throw Exception(__FILE__, __LINE__, "Every depth sequence needs own container.");
+    }
+    // Feature binaries recognize container by extension
+    for (const string& outFilename : outFilenames) {
+        if (!DepthContainer::isContainer(outFilename)) {
+            throw Exception(__FILE__, __LINE__, 
+                    "Container " + outFilename + " must end with " + DepthContainer::EXTENSION);
+        }
+    }
+}
+
+void PackTerminalParser::parsePackData() {
+    startFrame = std::max(parseMap["start-frame"].as<long>(), 1L);
+    frameCount = parseMap["frame-count"].as<long>();
+    if (frameCount < -1) {
+        throw Exception(__FILE__, __LINE__, "--frame-count must be -1 or more.");
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "planterminalparser.hpp"
+
+using namespace gk;
+
+PlanTerminalParser::PlanTerminalParser(int argc, const char** argv, int majorVersion, int minorVersion)
+: AbstractTerminalParser(majorVersion, minorVersion), description("Allowed options") {
+
+    description.add_options()
+            //
+            // help
+            ("help,h", "Produce help message")
+            //
+            // files
+            ("tracker-files", value< vector<string> >()->multitoken(), "Tracker files")
+            ("intrinsic-files", value< vector<string> >()->multitoken(), "Intrinsic files")
+            ("extrinsic-files", value< vector<string> >()->multitoken(), "Extrinsic files")
+            ("depth-files", value< vector<string> >()->multitoken(), "Sequence path for depth files")
+            ("selector-file", value< string >(), "Camera selector config file")
+            //
+            // out
+            ("out-plan", value<string>(), "Filename for selection plan")
+            //
+            // plan data
+            ("start-frame", value<long>()->default_value(1), "Start frame, same as for feature binaries")
+            ("frame-count", value<long>()->default_value(-1), "Frames to plan. If -1 until depth images end.")
+            ("scene-flow", value<bool>()->default_value(false), "Tracker files are for scene flow features, with confidence column")
+            ("prefetch-depth", value<int>()->default_value(4), "Depth images decoded ahead on background threads. If 0 they are decoded synchronously.")
+            ("prefetch-threads", value<int>()->default_value(1), "Threads decoding depth images of every camera")
+            ;
+    store(parse_command_line(argc, argv, description), parseMap);
+    notify(parseMap);
+}
+
+void PlanTerminalParser::parseInput() {
+    parseHelp();
+
+    parseFiles();
+    parsePlanData();
+}
+
+void PlanTerminalParser::parseHelp() {
+    if (parseMap.count("help")) {
+        cout << endl;
+        cout << "Version " << majorVersion << "." << minorVersion << endl;
+        cout << description << endl;
+        exit(EXIT_SUCCESS);
+    }
+}
+
+void PlanTerminalParser::parseFiles() {
+    if (parseMap.count("tracker-files")) {
+        trackerFilenames = expandNames(parseMap["tracker-files"].as< vector<string> >());
+
+    } else {
+        throw InvalidInputException(__FILE__, __LINE__, "--tracker-files");
+    }
+    if (parseMap.count("intrinsic-files")) {
+        intrinsicFilenames = expandNames(parseMap["intrinsic-files"].as< vector<string> >());
+
+    } else {
+        throw InvalidInputException(__FILE__, __LINE__, "--intrinsic-files");
+    }
+    if (parseMap.count("extrinsic-files")) {
+        extrinsicFilenames = expandNames(parseMap["extrinsic-files"].as< vector<string> >());
+
+    } else {
+        throw InvalidInputException(__FILE__, __LINE__, "--extrinsic-files");
+    }
+    if (parseMap.count("depth-files")) {
+        depthFilenames = expandNames(parseMap["depth-files"].as< vector<string> >());
+
+    } else {
+        throw InvalidInputException(__FILE__, __LINE__, "--depth-files");
+    }
+    if (parseMap.count("selector-file")) {
+        cameraSelectorFilename = expandName(parseMap["selector-file"].as< string >());
+
+    } else {
+        throw InvalidInputException(__FILE__, __LINE__, "--selector-file");
+    }
+    if (parseMap.count("out-plan")) {
+        outPlanFilename = expandName(parseMap["out-plan"].as< string >());
+
+    } else {
+        throw InvalidInputException(__FILE__, __LINE__, "--out-plan");
+    }
+}
+
+void PlanTerminalParser::parsePlanData() {
+    startFrame = parseMap["start-frame"].as<long>();
+    frameCount = parseMap["frame-count"].as<long>();
+    if (frameCount < -1) {
+        throw Exception(__FILE__, __LINE__, "--frame-count must be -1 or more.");
+    }
+    sceneFlowTracker = parseMap["scene-flow"].as<bool>();
+    prefetchDepth = parseMap["prefetch-depth"].as<int>();
+    prefetchThreads = parseMap["prefetch-threads"].as<int>();
+    if (prefetchDepth < 0 || prefetchThreads < 1) {
+        string message = "--prefetch-depth can't be negative and --prefetch-threads must be positive.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+}
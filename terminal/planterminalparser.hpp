@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLANTERMINALPARSER_HPP
+#define PLANTERMINALPARSER_HPP
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <boost/program_options.hpp>
+
+#include "abstractterminalparser.hpp"
+#include "exception.hpp"
+
+using namespace std;
+using namespace boost::program_options;
+
+namespace gk{
+    
+    class PlanTerminalParser : public AbstractTerminalParser {
+    private:
+        options_description description;
+        variables_map parseMap;
+        
+        void parseHelp() override;
+        void parseFiles();
+        void parsePlanData();
+        
+    public:
+        vector<string> trackerFilenames;
+        vector<string> intrinsicFilenames;
+        vector<string> extrinsicFilenames;
+        vector<string> depthFilenames;
+        
+        string cameraSelectorFilename;
+        string outPlanFilename;
+        
+        long startFrame;
+        // If -1 until depth images end
+        long frameCount;
+        // Tracker files of scene flow features, with confidence column
+        bool sceneFlowTracker;
+        // Depth images decoded ahead for every camera
+        int prefetchDepth;
+        int prefetchThreads;
+        
+        PlanTerminalParser(int argc, const char** argv, int majorVersion, int minorVersion);
+        void parseInput() override;
+    };
+}
+
+#endif /* PLANTERMINALPARSER_HPP */
+
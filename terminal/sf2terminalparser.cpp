@@ -36,6 +36,7 @@ SF2TerminalParser::SF2TerminalParser(int argc, const char** argv, int majorVersi
             ("intrinsic-files", value< vector<string> >()->multitoken(), "Intrinsic files")
             ("extrinsic-files", value< vector<string> >()->multitoken(), "Extrinsic files")
             ("selector-file", value< string >(), "Camera selector config file")
+            ("selection-plan", value< string >(), "Precomputed camera selection plan. Replaces --selector-file, so depth is not loaded for selection.")
             //
             // out
             ("flo-file", value<string>(), "Filename for FLO file")
@@ -54,6 +55,14 @@ SF2TerminalParser::SF2TerminalParser(int argc, const char** argv, int majorVersi
             ("rows", value<unsigned int>()->default_value(424), "Number of rows at the finest level of the pyramid.\nOptions: r=15, r=30, r=60, r=120, r=240, r=424 (if VGA)")
             ("sf-video", value<string>(), "Output optical flow video")
             ("display-flow", value<bool>()->default_value(false), "Display flow during calculation")
+            ("camera-threads", value<int>()->default_value(-1), "Extra threads updating cameras in parallel. If -1 every camera gets own thread.")
+            ("prefetch-depth", value<int>()->default_value(4), "BGR and depth images decoded ahead on background threads. If 0 they are decoded synchronously.")
+            ("prefetch-threads", value<int>()->default_value(1), "Threads decoding BGR or depth images of every camera")
+            //
+            // executor data
+            ("threads", value<int>()->default_value(0), "Cores shared by camera threads and OpenCV. If 0 all cores are used.")
+            ("opencv-threads", value<int>()->default_value(-1), "Threads of OpenCV pool, shared by all camera threads. If -1 all cores with one camera thread and 1 with more.")
+            ("pin-threads", value<bool>()->default_value(false), "Pin every camera thread to own slice of cores")
             //
             // angle descriptor data
             ("hd-b", value<int>()->default_value(60), "Bin count for angle descriptor")
@@ -70,6 +79,8 @@ SF2TerminalParser::SF2TerminalParser(int argc, const char** argv, int majorVersi
             "for large displacements set this < 1 to prevent clipping, for now should be 1.0")
             ("ad-max-norm", value<float>()->default_value(0.0),
             "For determining max norm range. If 0 norm will not be used.")
+            ("descriptor-isa", value<string>()->default_value("auto"),
+            "Instruction set for descriptor histograms: auto, scalar, sse4.2, avx2 or avx512")
             ;
     store(parse_command_line(argc, argv, description), parseMap);
     notify(parseMap);
@@ -83,7 +94,9 @@ void SF2TerminalParser::parseInput() {
     parseSceneFlowData();
     parseAngleDescriptor();
     parseAmplitudeDescriptor();
+    parseDescriptorIsa();
     parseCameraSelectorData();
+    parseExecutorData();
 }
 
 void SF2TerminalParser::parseHelp() {
@@ -205,6 +218,16 @@ void SF2TerminalParser::parseSceneFlowData() {
     sceneFlowData.displayFlow = parseMap["display-flow"].as<bool>();
     sceneFlowData.ctf = parseMap["ctf"].as<unsigned int>();
     sceneFlowData.rows = parseMap["rows"].as<unsigned int>();
+    sceneFlowData.cameraThreads = parseMap["camera-threads"].as<int>();
+    if (sceneFlowData.cameraThreads < -1) {
+        throw Exception(__FILE__, __LINE__, "--camera-threads must be -1 or more.");
+    }
+    sceneFlowData.prefetchDepth = parseMap["prefetch-depth"].as<int>();
+    sceneFlowData.prefetchThreads = parseMap["prefetch-threads"].as<int>();
+    if (sceneFlowData.prefetchDepth < 0 || sceneFlowData.prefetchThreads < 1) {
+        string message = "--prefetch-depth can't be negative and --prefetch-threads must be positive.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
     if (parseMap.count("sf-video")) {
         sceneFlowData.outVideo = expandName(parseMap["sf-video"].as<string>());
         sceneFlowData.needVideo = true;
@@ -228,8 +251,22 @@ void SF2TerminalParser::parseAmplitudeDescriptor() {
     amplitudeDescriptorData.maxNorm = parseMap["ad-max-norm"].as<float>();
 }
 
+void SF2TerminalParser::parseDescriptorIsa() {
+    descriptorIsa = HistogramKernels::fromName(parseMap["descriptor-isa"].as<string>());
+    if (!HistogramKernels::isSupported(descriptorIsa)) {
+        string message = "--descriptor-isa " + HistogramKernels::getName(descriptorIsa) 
+                + " is not supported by this CPU.";
+        throw Exception(__FILE__, __LINE__, message);
+    }
+}
+
 void SF2TerminalParser::parseCameraSelectorData() {
-    if (parseMap.count("selector-file")) {
+    if (parseMap.count("selection-plan")) {
+        selectionPlanFilename = expandName(parseMap["selection-plan"].as< string >());
+#ifdef DEBUG
+        cout << "Selection plan: " << selectionPlanFilename << endl;
+#endif
+    } else if (parseMap.count("selector-file")) {
         cameraSelectorFilename = expandName(parseMap["selector-file"].as< string >());
 #ifdef DEBUG
         cout << "Camera selector file: " << cameraSelectorFilename << endl;
@@ -237,4 +274,16 @@ void SF2TerminalParser::parseCameraSelectorData() {
     } else {
         throw InvalidInputException(__FILE__, __LINE__, "--selector-file");
     }
-}
\ No newline at end of file
+}
+
+void SF2TerminalParser::parseExecutorData() {
+    executorData.threads = parseMap["threads"].as<int>();
+    executorData.openCvThreads = parseMap["opencv-threads"].as<int>();
+    executorData.pinThreads = parseMap["pin-threads"].as<bool>();
+    if (executorData.threads < 0) {
+        throw Exception(__FILE__, __LINE__, "--threads must be 0 or more.");
+    }
+    if (executorData.openCvThreads == 0 || executorData.openCvThreads < -1) {
+        throw Exception(__FILE__, __LINE__, "--opencv-threads must be -1 or positive.");
+    }
+}
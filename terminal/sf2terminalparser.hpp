@@ -26,7 +26,9 @@
 
 #include "abstractterminalparser.hpp"
 #include "basedescriptor.hpp"
+#include "histogramkernels.hpp"
 #include "basetrackerfile.hpp"
+#include "executor.hpp"
 
 using namespace std;
 using namespace boost::program_options;
@@ -40,6 +42,12 @@ namespace gk{
         unsigned int rows;
         string outVideo;
         bool needVideo;
+        // Threads updating cameras besides main thread, -1 for one per camera
+        int cameraThreads;
+        // Image and depth frames decoded ahead, 0 decodes them 
+        // synchronously
+        int prefetchDepth;
+        int prefetchThreads;
     };
     
     class SF2TerminalParser : public AbstractTerminalParser {     
@@ -53,7 +61,9 @@ namespace gk{
         void parseSceneFlowData();
         void parseAngleDescriptor();
         void parseAmplitudeDescriptor();
+        void parseDescriptorIsa();
         void parseCameraSelectorData();
+        void parseExecutorData();
         
     public:
         vector<string> videoFilenames;
@@ -65,6 +75,8 @@ namespace gk{
         vector<string> depthFilenames;
 
         string cameraSelectorFilename;
+        // If set, camera selector isn't used
+        string selectionPlanFilename;
         string floFilename;
         long floFrameCount;
         string outHistFilename;
@@ -72,9 +84,11 @@ namespace gk{
 
         int startFrame;
         TrackerData trackerData;
+        ExecutorData executorData;
         SceneFlowData sceneFlowData;
         DescriptorData angleDescriptorData;
         DescriptorData amplitudeDescriptorData;
+        KernelIsa descriptorIsa;
 
         SF2TerminalParser(int argc, const char** argv, int majorVersion, int minorVersion);
         void parseInput() override;
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Bins of Cartesian flow must be same as bins of reference path, that is 
+ * cartToPolar(), normalizeAngles() and binning of angles, for random 
+ * vectors and for vectors on and around every bin edge.
+ */
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <iostream>
+
+#include "angledescriptor.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+static const int BIN_COUNTS[] = {2, 4, 8, 12, 16, 30, 36};
+
+// Mismatches printed for each bin count
+static const int PRINTED_MISMATCHES = 5;
+
+/**
+ * @return One-hot histogram of single vector.
+ */
+static vector<float> getCartesianHistogram(AngleDescriptor& descriptor, float dx, float dy) {
+    Mat flow(1, 1, CV_32FC2);
+    flow.at<Vec2f>(0, 0) = Vec2f(dx, dy);
+    Mat magnitude(1, 1, CV_32FC1, Scalar(1));
+    vector<float> histogram;
+    descriptor.getHistogram(flow, magnitude, histogram);
+    return histogram;
+}
+
+static vector<float> getAngleHistogram(AngleDescriptor& descriptor, float angle) {
+    Mat angles(1, 1, CV_32FC1, Scalar(angle));
+    Mat magnitude(1, 1, CV_32FC1, Scalar(1));
+    vector<float> histogram;
+    descriptor.getHistogram(angles, magnitude, histogram);
+    return histogram;
+}
+
+/**
+ * Vectors are in one row, so cartToPolar() takes its vectorized path as
+ * it does for flow.
+ */
+static int countMismatches(const vector<Vec2f>& vectors, const int binCount) {
+    AngleDescriptor descriptor(binCount, 0);
+    
+    Mat dx(1, (int) vectors.size(), CV_32FC1);
+    Mat dy(1, (int) vectors.size(), CV_32FC1);
+    for (size_t i = 0; i < vectors.size(); i++) {
+        dx.at<float>(0, i) = vectors[i][0];
+        dy.at<float>(0, i) = vectors[i][1];
+    }
+    Mat magnitudes, angles;
+    cartToPolar(dx, dy, magnitudes, angles);
+    AngleDescriptor::normalizeAngles(angles);
+    
+    int mismatches = 0;
+    for (size_t i = 0; i < vectors.size(); i++) {
+        float angle = angles.at<float>(0, i);
+        if (getCartesianHistogram(descriptor, vectors[i][0], vectors[i][1]) != 
+                getAngleHistogram(descriptor, angle)) {
+            if (mismatches < PRINTED_MISMATCHES) {
+                cout.precision(9);
+                cout << "Bins " << binCount << ": (" << vectors[i][0] << ", " 
+                        << vectors[i][1] << ") angle " << angle << endl;
+            }
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static void addNeighbours(vector<Vec2f>& vectors, float dx, float dy) {
+    for (int i = -1; i <= 1; i++) {
+        for (int j = -1; j <= 1; j++) {
+            float x = i == 0 ? dx : std::nextafter(dx, i * INFINITY);
+            float y = j == 0 ? dy : std::nextafter(dy, j * INFINITY);
+            vectors.push_back(Vec2f(x, y));
+        }
+    }
+}
+
+static vector<Vec2f> getEdgeVectors(const int binCount) {
+    vector<Vec2f> vectors;
+    
+    // Zero, vertical and horizontal vectors
+    addNeighbours(vectors, 0, 0);
+    for (float length : {1e-30f, 1e-3f, 1.f, 1e3f}) {
+        addNeighbours(vectors, 0, length);
+        addNeighbours(vectors, 0, -length);
+        addNeighbours(vectors, length, 0);
+        addNeighbours(vectors, -length, 0);
+    }
+    
+    // Every bin edge in both half planes, from exact and float angle
+    double binWidth = CV_PI / binCount;
+    for (int k = 0; k <= binCount; k++) {
+        double edge = -CV_PI / 2 + k * binWidth;
+        float floatEdge = (float) (-CV_PI / 2) + k * (float) binWidth;
+        for (double angle : {edge, (double) floatEdge, 
+                (double) std::nextafter(floatEdge, -INFINITY), 
+                (double) std::nextafter(floatEdge, INFINITY)}) {
+            for (float length : {1e-30f, 1e-14f, 1e-3f, 1.f, 7.5f, 1e3f}) {
+                float x = (float) (length * std::cos(angle));
+                float y = (float) (length * std::sin(angle));
+                addNeighbours(vectors, x, y);
+                addNeighbours(vectors, -x, y);
+            }
+        }
+    }
+    return vectors;
+}
+
+static vector<Vec2f> getRandomVectors(const int count) {
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> flow(-20, 20);
+    std::uniform_real_distribution<float> small(-1e-3f, 1e-3f);
+    
+    vector<Vec2f> vectors;
+    for (int i = 0; i < count; i++) {
+        if (i % 4 == 0) {
+            // Tiny flow, as of still background
+            vectors.push_back(Vec2f(small(generator), small(generator)));
+        } else {
+            vectors.push_back(Vec2f(flow(generator), flow(generator)));
+        }
+    }
+    return vectors;
+}
+
+int main(int argc, char** argv) {
+    vector<Vec2f> randomVectors = getRandomVectors(100000);
+    for (int binCount : BIN_COUNTS) {
+        CHECK(countMismatches(getEdgeVectors(binCount), binCount) == 0);
+        CHECK(countMismatches(randomVectors, binCount) == 0);
+    }
+    return gk::test::testResult();
+}
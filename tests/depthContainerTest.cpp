@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Depth frames written to a container must be read back unchanged, with
+ * missing frames, time stamps and broken files handled.
+ */
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+
+#include <boost/filesystem.hpp>
+
+#include "depthcontainer.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+// Odd width, so frames end off 8-byte alignment
+static const int WIDTH = 7;
+static const int HEIGHT = 3;
+
+static Mat makeDepth(int frame) {
+    Mat depth(HEIGHT, WIDTH, CV_16UC1, Scalar(0));
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            depth.at<uint16_t>(y, x) = (uint16_t) (frame * 1000 + y * WIDTH + x);
+        }
+    }
+    return depth;
+}
+
+static bool isSame(const Mat& depth, int frame) {
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            if (depth.ptr<uint16_t>(y)[x] != (uint16_t) (frame * 1000 + y * WIDTH + x)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void testRoundTrip(const string& filename) {
+    // Frames 3 to 7, frame 5 is missing
+    {
+        DepthContainerWriter writer(filename, Size(WIDTH, HEIGHT), 3);
+        for (int frame = 3; frame <= 7; frame++) {
+            writer.write(frame == 5 ? Mat() : makeDepth(frame), frame * 33);
+        }
+        CHECK_THROWS(writer.write(Mat(HEIGHT + 1, WIDTH, CV_16UC1, Scalar(0)), 0));
+        writer.close();
+    }
+    
+    CHECK(DepthContainer::isContainer(filename));
+    DepthContainer container(filename);
+    CHECK(container.getFirstFrame() == 3);
+    CHECK(container.getFrameCount() == 5);
+    CHECK(container.getFrameSize() == Size(WIDTH, HEIGHT));
+    
+    for (int frame = 3; frame <= 7; frame++) {
+        if (frame == 5) {
+            CHECK(!container.contains(frame));
+            CHECK_THROWS(container.getFrame(frame));
+            continue;
+        }
+        CHECK(container.contains(frame));
+        Mat depth = container.getFrame(frame);
+        CHECK(depth.type() == CV_16UC1 && depth.size() == Size(WIDTH, HEIGHT));
+        CHECK(isSame(depth, frame));
+        CHECK(container.getTimeStamp(frame) == frame * 33);
+    }
+    CHECK(!container.contains(2) && !container.contains(8));
+    CHECK_THROWS(container.getTimeStamp(8));
+}
+
+static void testBrokenFiles(const string& directory, const string& filename) {
+    CHECK(!DepthContainer::isContainer(directory + "/depth_%04d.png"));
+    CHECK_THROWS(DepthContainer(directory + "/missing" + DepthContainer::EXTENSION));
+    
+    string other = directory + "/other" + DepthContainer::EXTENSION;
+    {
+        ofstream os(other);
+        os << "Not a depth container, but long enough to hold its header." << endl;
+    }
+    CHECK_THROWS(DepthContainer container(other));
+    
+    // Frame count and frame size so large that they overflow checks
+    // done by addition or multiplication
+    for (int field = 0; field < 2; field++) {
+        boost::filesystem::copy_file(filename, other, 
+                boost::filesystem::copy_option::overwrite_if_exists);
+        DepthContainer::Header header;
+        {
+            ifstream is(filename, ios::binary);
+            is.read((char*) &header, sizeof (header));
+        }
+        if (field == 0) {
+            header.frameCount = INT64_MAX / 8;
+        } else {
+            header.width = UINT32_MAX;
+            header.height = UINT32_MAX;
+        }
+        fstream os(other, ios::binary | ios::in | ios::out);
+        os.write((const char*) &header, sizeof (header));
+        os.close();
+        CHECK_THROWS(DepthContainer container(other));
+    }
+    
+    // Offset of frame past end of file
+    boost::filesystem::copy_file(filename, other, 
+            boost::filesystem::copy_option::overwrite_if_exists);
+    {
+        DepthContainer::Header header;
+        fstream os(other, ios::binary | ios::in | ios::out);
+        os.read((char*) &header, sizeof (header));
+        uint64_t offset = UINT64_MAX - 8;
+        os.seekp(header.tableOffset);
+        os.write((const char*) &offset, sizeof (offset));
+    }
+    {
+        DepthContainer container(other);
+        CHECK_THROWS(container.getFrame(3));
+    }
+    
+    // Tables are at the end, so cut file has none
+    boost::filesystem::copy_file(filename, other, 
+            boost::filesystem::copy_option::overwrite_if_exists);
+    boost::filesystem::resize_file(other, boost::filesystem::file_size(filename) / 2);
+    CHECK_THROWS(DepthContainer container(other));
+}
+
+static void testFullDisk() {
+    if (!boost::filesystem::exists("/dev/full")) {
+        return;
+    }
+    // Small frame stays in buffer until tables are written
+    DepthContainerWriter writer("/dev/full", Size(WIDTH, HEIGHT), 1);
+    writer.write(makeDepth(1), 0);
+    CHECK_THROWS(writer.close());
+}
+
+int main(int argc, char** argv) {
+    string directory = gk::test::makeTempDirectory();
+    string filename = directory + "/depth" + DepthContainer::EXTENSION;
+    
+    testRoundTrip(filename);
+    testBrokenFiles(directory, filename);
+    testFullDisk();
+    
+    boost::filesystem::remove_all(directory);
+    return gk::test::testResult();
+}
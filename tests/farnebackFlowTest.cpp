@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Native Farneback must give the same flow as calcOpticalFlowFarneback().
+ * Also prints time of both on sequence of frames, where native Farneback
+ * reuses expansion of previous frame.
+ */
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+
+#include <vector>
+
+#include "farnebackflow.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+struct FarnebackParams {
+    double pyramidScale;
+    int pyramidLayers;
+    int windowSize;
+    int iterationsCount;
+    int neighbourSize;
+    double gaussianDeviation;
+    int operationFlags;
+};
+
+static void makeSequence(int frameCount, vector<Mat>& frames) {
+    RNG rng(31);
+    Mat noise(480, 640, CV_8UC1);
+    rng.fill(noise, RNG::UNIFORM, 0, 256);
+    Mat texture;
+    GaussianBlur(noise, texture, Size(0, 0), 2.0);
+    normalize(texture, texture, 0, 255, NORM_MINMAX);
+    
+    for (int i = 0; i < frameCount; i++) {
+        Mat translation = (Mat_<double>(2, 3) << 1, 0, 1.0 * i, 0, 1, 0.5 * i);
+        Mat frame;
+        warpAffine(texture, frame, translation, texture.size(), INTER_LINEAR, BORDER_REFLECT);
+        frames.push_back(frame);
+    }
+}
+
+static double getEndpointError(const Mat& flow, const Mat& expected) {
+    Mat difference = flow - expected;
+    vector<Mat> channels;
+    split(difference, channels);
+    Mat endpointError;
+    magnitude(channels[0], channels[1], endpointError);
+    return mean(endpointError)[0];
+}
+
+static void compare(const string& name, const FarnebackParams& p) {
+    vector<Mat> frames;
+    makeSequence(10, frames);
+    
+    FarnebackFlow farnebackFlow(p.pyramidScale, p.pyramidLayers, p.windowSize,
+            p.iterationsCount, p.neighbourSize, p.gaussianDeviation, p.operationFlags);
+    
+    double openCvTime = 0, nativeTime = 0, maxError = 0;
+    for (size_t i = 1; i < frames.size(); i++) {
+        Mat expected, flow;
+        
+        int64 start = getTickCount();
+        calcOpticalFlowFarneback(frames[i - 1], frames[i], expected,
+                p.pyramidScale, p.pyramidLayers, p.windowSize,
+                p.iterationsCount, p.neighbourSize, p.gaussianDeviation, p.operationFlags);
+        openCvTime += (getTickCount() - start) / getTickFrequency();
+        
+        start = getTickCount();
+        farnebackFlow.calc(frames[i - 1], frames[i], flow);
+        nativeTime += (getTickCount() - start) / getTickFrequency();
+        
+        CHECK(flow.size() == expected.size() && flow.type() == CV_32FC2);
+        if (flow.size() == expected.size() && flow.type() == CV_32FC2) {
+            maxError = std::max(maxError, getEndpointError(flow, expected));
+        }
+    }
+    
+    int pairCount = (int) frames.size() - 1;
+    cout << name << ": mean EPE up to " << maxError << " px, "
+            << "OpenCV " << openCvTime * 1000 / pairCount << " ms, "
+            << "native " << nativeTime * 1000 / pairCount << " ms per pair" << endl;
+    CHECK(maxError < 0.01);
+}
+
+int main(int argc, char** argv) {
+    FarnebackParams box = {0.5, 3, 15, 3, 5, 1.2, 0};
+    compare("Box window", box);
+    
+    // Even window is 2*(windowSize/2)+1 wide
+    FarnebackParams evenBox = {0.5, 3, 14, 3, 5, 1.2, 0};
+    compare("Even box window", evenBox);
+    
+    FarnebackParams gaussian = {0.5, 3, 15, 3, 7, 1.5, OPTFLOW_FARNEBACK_GAUSSIAN};
+    compare("Gaussian window", gaussian);
+    
+    return gk::test::testResult();
+}
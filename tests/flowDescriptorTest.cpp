@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Histograms of fused flow descriptor must be same as histograms of 
+ * reference path, that is split(), cartToPolar(), AmplitudeFactor::scale(),
+ * AngleDescriptor::normalizeAngles() and getHistogram() of both 
+ * descriptors.
+ */
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+#include <memory>
+#include <cmath>
+
+#include "flowdescriptor.hpp"
+#include "amplitudefactor.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+/**
+ * Rotation and expansion around center, still background in top left 
+ * corner and exactly vertical and horizontal flow along center lines.
+ */
+static Mat makeFlow(const Size& size) {
+    Mat flow(size, CV_32FC2);
+    float cx = size.width / 2, cy = size.height / 2;
+    for (int y = 0; y < size.height; y++) {
+        for (int x = 0; x < size.width; x++) {
+            Vec2f& v = flow.at<Vec2f>(y, x);
+            if (x < size.width / 4 && y < size.height / 4) {
+                v = Vec2f(0, 0);
+            } else {
+                float rx = (x - cx) / cx, ry = (y - cy) / cy;
+                v = Vec2f(3 * rx - 5 * ry, 5 * rx + 3 * ry);
+            }
+        }
+    }
+    return flow;
+}
+
+static void getReferenceHistograms(const Mat& flow, const Rect2d& roi,
+        const std::shared_ptr<AmplitudeFactor>& amplitudeFactor,
+        AngleDescriptor& angleDescriptor, AmplitudeDescriptor& amplitudeDescriptor,
+        vector<float>& angleHistogram, vector<float>& amplitudeHistogram) {
+    
+    vector<Mat> channel;
+    split(flow, channel);
+    Mat magnitude, angle;
+    cartToPolar(channel[0], channel[1], magnitude, angle, false);
+    if (amplitudeFactor) {
+        amplitudeFactor->scale(magnitude, roi);
+    }
+    AngleDescriptor::normalizeAngles(angle);
+    
+    angleDescriptor.getHistogram(angle, magnitude, angleHistogram);
+    amplitudeDescriptor.getHistogram(magnitude, amplitudeHistogram);
+}
+
+/**
+ * Weights are summed in other order, so angle bins may differ in last 
+ * bits. Amplitude bins count pixels and must be same.
+ */
+static bool isClose(const vector<float>& a, const vector<float>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::abs(a[i] - b[i]) > 1e-5f * std::max(std::abs(a[i]), 1.f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void compare(const Mat& flow, const Rect2d& roi, 
+        const std::shared_ptr<AmplitudeFactor>& amplitudeFactor,
+        const std::shared_ptr<AngleDescriptor>& angleDescriptor,
+        const std::shared_ptr<AmplitudeDescriptor>& amplitudeDescriptor) {
+    
+    vector<float> angleHistogram, amplitudeHistogram;
+    getReferenceHistograms(flow, roi, amplitudeFactor, *angleDescriptor, 
+            *amplitudeDescriptor, angleHistogram, amplitudeHistogram);
+    
+    FlowDescriptor flowDescriptor(angleDescriptor, amplitudeDescriptor);
+    float factor = amplitudeFactor ? amplitudeFactor->getFactor(roi) : 1;
+    vector<float> fusedAngleHistogram, fusedAmplitudeHistogram;
+    flowDescriptor.getHistograms(flow, factor, fusedAngleHistogram, fusedAmplitudeHistogram);
+    
+    CHECK(isClose(fusedAngleHistogram, angleHistogram));
+    CHECK(fusedAmplitudeHistogram == amplitudeHistogram);
+}
+
+int main(int argc, char** argv) {
+    Mat flow = makeFlow(Size(97, 61));
+    Rect2d frame(0, 0, flow.cols, flow.rows);
+    
+    // Defaults of terminal parsers, and normalized histograms with noise
+    // threshold
+    auto angles = std::make_shared<AngleDescriptor>(60, 0);
+    auto amplitudes = std::make_shared<AmplitudeDescriptor>(60, 0, 1, 0);
+    auto normalizedAngles = std::make_shared<AngleDescriptor>(16, 1);
+    auto normalizedAmplitudes = std::make_shared<AmplitudeDescriptor>(20, 0.5, 2.5, 1);
+    auto amplitudeFactor = std::make_shared<AmplitudeFactor>(200);
+    
+    compare(flow, frame, NULL, angles, amplitudes);
+    compare(flow, frame, NULL, normalizedAngles, normalizedAmplitudes);
+    compare(flow, frame, amplitudeFactor, angles, amplitudes);
+    compare(flow, frame, amplitudeFactor, normalizedAngles, normalizedAmplitudes);
+    
+    // Crop of ROI isn't continuous, as crop of flow
+    Rect2d roi(13, 7, 40, 30);
+    Mat crop = flow(Rect(13, 7, 40, 30));
+    compare(crop, roi, NULL, angles, amplitudes);
+    compare(crop, roi, amplitudeFactor, angles, amplitudes);
+    compare(crop, roi, amplitudeFactor, normalizedAngles, normalizedAmplitudes);
+    
+    // Missing descriptor has empty histogram
+    vector<float> angleHistogram, amplitudeHistogram;
+    FlowDescriptor(angles, NULL).getHistograms(flow, 1, angleHistogram, amplitudeHistogram);
+    CHECK(angleHistogram.size() == 60 && amplitudeHistogram.empty());
+    FlowDescriptor(NULL, amplitudes).getHistograms(Mat(), 1, angleHistogram, amplitudeHistogram);
+    CHECK(angleHistogram.empty() && amplitudeHistogram == vector<float>(60));
+    
+    return gk::test::testResult();
+}
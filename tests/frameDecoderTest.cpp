@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Frames of decoder must be same as frames of VideoCapture, with and 
+ * without decoding ahead, and must end with end of stream. Frames that 
+ * aren't needed are empty. Gray frames are converted frames of 
+ * VideoCapture.
+ */
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "framedecoder.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+static const int FRAME_COUNT = 12;
+static const int DEPTHS[] = {0, 1, 3};
+
+static string videoFilename;
+// Frames decoded by VideoCapture
+static vector<Mat> frames;
+
+static bool isSame(const Mat& a, const Mat& b) {
+    return a.size() == b.size() && a.type() == b.type() && 
+            norm(a, b, NORM_INF) == 0;
+}
+
+static void writeVideo(const string& filename) {
+    VideoWriter writer(filename, VideoWriter::fourcc('M', 'J', 'P', 'G'), 25, Size(64, 48));
+    CHECK(writer.isOpened());
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        Mat frame(48, 64, CV_8UC3, Scalar(20 * i, 255 - 20 * i, 100));
+        rectangle(frame, Rect(4 * i, 8, 10, 10), Scalar(255, 255, 255), -1);
+        writer.write(frame);
+    }
+}
+
+static void readVideo(const string& filename) {
+    VideoCapture capture(filename);
+    Mat frame;
+    while (capture.read(frame)) {
+        frames.push_back(frame.clone());
+    }
+    CHECK(frames.size() == FRAME_COUNT);
+}
+
+static void testAllFrames(const int depth) {
+    FrameDecoder decoder(videoFilename, depth);
+    CHECK(decoder.isOpened() && decoder.getDepth() == depth);
+    CHECK(decoder.get(CAP_PROP_FRAME_WIDTH) == 64 && decoder.get(CAP_PROP_FRAME_HEIGHT) == 48);
+    
+    Mat frame, previous;
+    int count = 0;
+    bool same = true;
+    while (decoder.read(frame)) {
+        same = same && count < FRAME_COUNT && isSame(frame, frames[count]);
+        // Previous frame stays valid until second next read
+        same = same && (count == 0 || isSame(previous, frames[count - 1]));
+        previous = frame;
+        count++;
+    }
+    CHECK(same);
+    CHECK(count == FRAME_COUNT);
+    
+    // Stays at end of stream
+    CHECK(!decoder.read(frame));
+}
+
+static void testNeededFrames(const int depth) {
+    // Frames after end of neededFrames are needed
+    vector<bool> neededFrames = {true, false, false, true, true, false};
+    FrameDecoder decoder(videoFilename, depth, neededFrames);
+    
+    Mat frame;
+    int count = 0;
+    bool same = true;
+    while (decoder.read(frame)) {
+        if (count < (int) neededFrames.size() && !neededFrames[count]) {
+            same = same && frame.empty();
+        } else {
+            same = same && isSame(frame, frames[count]);
+        }
+        count++;
+    }
+    CHECK(same);
+    CHECK(count == FRAME_COUNT);
+}
+
+static void testStartFrame(const int depth) {
+    FrameDecoder decoder(videoFilename, depth, vector<bool>(), 5);
+    Mat frame;
+    CHECK(decoder.read(frame) && isSame(frame, frames[5]));
+    
+    // Start after end of stream
+    FrameDecoder after(videoFilename, depth, vector<bool>(), FRAME_COUNT + 3);
+    CHECK(!after.read(frame));
+}
+
+static void testGray(const int depth) {
+    vector<bool> neededFrames = {true, false, true};
+    FrameDecoder decoder(videoFilename, depth, neededFrames, 0, true);
+    
+    Mat frame, gray;
+    int count = 0;
+    bool same = true;
+    while (decoder.read(frame)) {
+        if (count < (int) neededFrames.size() && !neededFrames[count]) {
+            same = same && frame.empty();
+        } else {
+            cvtColor(frames[count], gray, COLOR_BGR2GRAY);
+            same = same && frame.type() == CV_8UC1 && isSame(frame, gray);
+        }
+        count++;
+    }
+    CHECK(same);
+    CHECK(count == FRAME_COUNT);
+}
+
+int main(int argc, char** argv) {
+    string directory = gk::test::makeTempDirectory();
+    videoFilename = directory + "/video.avi";
+    writeVideo(videoFilename);
+    readVideo(videoFilename);
+    
+    if (frames.size() == FRAME_COUNT) {
+        for (int depth : DEPTHS) {
+            testAllFrames(depth);
+            testNeededFrames(depth);
+            testStartFrame(depth);
+            testGray(depth);
+        }
+    }
+    
+    boost::filesystem::remove_all(directory);
+    return gk::test::testResult();
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SSE4.2, AVX2 and AVX-512 histogram kernels must give the same 
+ * histograms as scalar kernels, bit for bit, also for row lengths which
+ * are not multiple of vector width.
+ */
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+#include <random>
+#include <cmath>
+
+#include "histogramkernels.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+static const int BIN_COUNT = 60;
+
+static Mat makeMat(int rows, int cols, float low, float high, std::mt19937& random) {
+    std::uniform_real_distribution<float> distribution(low, high);
+    Mat values(rows, cols, CV_32FC1);
+    for (int y = 0; y < rows; y++) {
+        float* row = values.ptr<float>(y);
+        for (int x = 0; x < cols; x++) {
+            row[x] = distribution(random);
+        }
+    }
+    
+    // Bin edges and values outside histogram
+    if (cols > 2) {
+        values.ptr<float>(0)[0] = low;
+        values.ptr<float>(0)[1] = high;
+        values.ptr<float>(0)[2] = 0.f;
+    }
+    return values;
+}
+
+static void calculate(KernelIsa isa, const Mat& angles, const Mat& magnitudes,
+        vector<float>& angleHistogram, vector<float>& amplitudeHistogram) {
+    
+    HistogramKernels::setIsa(isa);
+    float binWidth = (float) (2 * CV_PI / BIN_COUNT);
+    HistogramKernels::angleHistogram(angles, magnitudes, (float) -CV_PI, binWidth, 
+            BIN_COUNT, angleHistogram);
+    HistogramKernels::amplitudeHistogram(magnitudes, 4.f, 0.5f, BIN_COUNT, 
+            amplitudeHistogram);
+}
+
+static void compareWithScalar(KernelIsa isa) {
+    if (!HistogramKernels::isSupported(isa)) {
+        cout << HistogramKernels::getName(isa) << " not supported, skipped." << endl;
+        return;
+    }
+    
+    std::mt19937 random(7);
+    int widths[] = {1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 33, 47, 64, 100, 257};
+    for (int cols : widths) {
+        Mat angles = makeMat(5, cols, (float) -CV_PI - 0.1f, (float) CV_PI + 0.1f, random);
+        // Negative amplitudes are counted by absolute value
+        Mat magnitudes = makeMat(5, cols, -20.f, 20.f, random);
+        
+        vector<float> scalarAngles, scalarAmplitudes, angleHistogram, amplitudeHistogram;
+        calculate(ISA_SCALAR, angles, magnitudes, scalarAngles, scalarAmplitudes);
+        calculate(isa, angles, magnitudes, angleHistogram, amplitudeHistogram);
+        
+        CHECK(angleHistogram == scalarAngles);
+        CHECK(amplitudeHistogram == scalarAmplitudes);
+        if (angleHistogram != scalarAngles || amplitudeHistogram != scalarAmplitudes) {
+            cerr << HistogramKernels::getName(isa) << " differs for " << cols << " columns" << endl;
+        }
+    }
+}
+
+static void compareWithPlainLoop() {
+    std::mt19937 random(11);
+    Mat angles = makeMat(7, 45, (float) -CV_PI, (float) CV_PI, random);
+    Mat magnitudes = makeMat(7, 45, 0.f, 20.f, random);
+    
+    vector<float> angleHistogram, amplitudeHistogram;
+    calculate(ISA_AUTO, angles, magnitudes, angleHistogram, amplitudeHistogram);
+    
+    float binWidth = (float) (2 * CV_PI / BIN_COUNT);
+    vector<float> expectedAngles(BIN_COUNT), expectedAmplitudes(BIN_COUNT);
+    for (int y = 0; y < angles.rows; y++) {
+        for (int x = 0; x < angles.cols; x++) {
+            int bin = cvFloor((angles.ptr<float>(y)[x] + (float) CV_PI) / binWidth);
+            if (bin > 0 && bin < BIN_COUNT) {
+                expectedAngles[bin] += magnitudes.ptr<float>(y)[x];
+            }
+            float amplitude = std::abs(magnitudes.ptr<float>(y)[x]) * 4.f;
+            if (amplitude >= 0.5f && (unsigned int) (amplitude - 0.5f) < (unsigned int) BIN_COUNT) {
+                expectedAmplitudes[(unsigned int) (amplitude - 0.5f)] += 1.f;
+            }
+        }
+    }
+    
+    // Counts are exact, sums of magnitudes differ only by order
+    CHECK(amplitudeHistogram == expectedAmplitudes);
+    for (int bin = 0; bin < BIN_COUNT; bin++) {
+        CHECK(std::abs(angleHistogram[bin] - expectedAngles[bin]) <= 1e-5f * (1 + expectedAngles[bin]));
+    }
+}
+
+int main(int argc, char** argv) {
+    compareWithScalar(ISA_SSE42);
+    compareWithScalar(ISA_AVX2);
+    compareWithScalar(ISA_AVX512);
+    compareWithPlainLoop();
+    HistogramKernels::setIsa(ISA_AUTO);
+    
+    return gk::test::testResult();
+}
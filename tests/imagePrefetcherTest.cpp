@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Prefetcher must return frames of sequence in order with any depth and 
+ * thread count, empty frames that aren't needed, error of frame that 
+ * can't be read on that frame, and end on first frame missing when it 
+ * was made.
+ */
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include "imageprefetcher.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+static const int FRAME_COUNT = 10;
+static const int DEPTHS[] = {0, 1, 4};
+static const int THREAD_COUNTS[] = {1, 3};
+
+static string directory;
+
+static string makeSequence(const string& name) {
+    string sequenceDirectory = directory + "/" + name;
+    boost::filesystem::create_directories(sequenceDirectory);
+    return sequenceDirectory + "/depth_%04d.png";
+}
+
+static void writeFrame(const string& sequence, const long frame) {
+    Mat image(6, 8, CV_16UC1, Scalar(100 * frame));
+    CHECK(imwrite(str(boost::format(sequence) % frame), image));
+}
+
+static bool isFrame(Mat& image, const long frame) {
+    return !image.empty() && image.type() == CV_16UC1 && 
+            image.size() == Size(8, 6) && image.at<ushort>(0, 0) == 100 * frame;
+}
+
+static void testOrder(const string& sequence, const int depth, const int threads) {
+    ImagePrefetcher prefetcher(sequence, 1, depth, threads);
+    Mat image;
+    long frame = 1;
+    bool same = true;
+    while (prefetcher.getNext(image)) {
+        same = same && isFrame(image, frame) && 
+                prefetcher.getFilename() == str(boost::format(sequence) % frame);
+        frame++;
+    }
+    CHECK(same);
+    CHECK(frame - 1 == FRAME_COUNT);
+    // Stays at end
+    CHECK(!prefetcher.getNext(image));
+}
+
+static void testNeededFrames(const string& sequence, const int depth, const int threads) {
+    // Counted from start frame 2, frames after 6 are needed
+    vector<bool> neededFrames = {true, false, false, true, false};
+    ImagePrefetcher prefetcher(sequence, 2, depth, threads, neededFrames);
+    Mat image;
+    long frame = 2;
+    bool same = true;
+    while (prefetcher.getNext(image)) {
+        long index = frame - 2;
+        if (index < (long) neededFrames.size() && !neededFrames[index]) {
+            same = same && image.empty();
+        } else {
+            same = same && isFrame(image, frame);
+        }
+        frame++;
+    }
+    CHECK(same);
+    CHECK(frame - 1 == FRAME_COUNT);
+}
+
+static void testReadError(const int depth, const int threads) {
+    string sequence = makeSequence("broken" + to_string(depth) + "_" + to_string(threads));
+    for (long frame = 1; frame <= 6; frame++) {
+        writeFrame(sequence, frame);
+    }
+    // Frame 4 exists, so sequence doesn't end, but isn't image
+    ofstream(str(boost::format(sequence) % 4)) << "not an image";
+    
+    ImagePrefetcher prefetcher(sequence, 1, depth, threads);
+    Mat image;
+    for (long frame = 1; frame <= 3; frame++) {
+        CHECK(prefetcher.getNext(image) && isFrame(image, frame));
+    }
+    CHECK_THROWS(prefetcher.getNext(image));
+    // Reading continues after failed frame
+    for (long frame = 5; frame <= 6; frame++) {
+        CHECK(prefetcher.getNext(image) && isFrame(image, frame));
+    }
+    CHECK(!prefetcher.getNext(image));
+}
+
+static void testSequenceEnd(const int depth, const int threads) {
+    string sequence = makeSequence("gap" + to_string(depth) + "_" + to_string(threads));
+    for (long frame = 1; frame <= 7; frame++) {
+        if (frame != 6) {
+            writeFrame(sequence, frame);
+        }
+    }
+    
+    ImagePrefetcher prefetcher(sequence, 1, depth, threads);
+    // Directory was scanned already, sequence still ends before frame 6
+    writeFrame(sequence, 6);
+    Mat image;
+    long frame = 1;
+    while (prefetcher.getNext(image)) {
+        frame++;
+    }
+    CHECK(frame == 6);
+    
+    // Start frame after end of sequence
+    ImagePrefetcher after(sequence, 9, depth, threads);
+    CHECK(!after.getNext(image));
+}
+
+int main(int argc, char** argv) {
+    directory = gk::test::makeTempDirectory();
+    string sequence = makeSequence("sequence");
+    for (long frame = 1; frame <= FRAME_COUNT; frame++) {
+        writeFrame(sequence, frame);
+    }
+    
+    for (int depth : DEPTHS) {
+        for (int threads : THREAD_COUNTS) {
+            testOrder(sequence, depth, threads);
+            testNeededFrames(sequence, depth, threads);
+            testReadError(depth, threads);
+            testSequenceEnd(depth, threads);
+        }
+    }
+    
+    boost::filesystem::remove_all(directory);
+    return gk::test::testResult();
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Keyframe index must survive cache round trip exactly, stale or 
+ * incomplete caches must not be used, and seek points must be found for
+ * any frame.
+ */
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#include <boost/filesystem.hpp>
+
+#include "keyframeindex.hpp"
+#include "testcheck.hpp"
+
+using namespace std;
+using namespace gk;
+
+// 601 frames at 29.97 fps, time stamps don't have exact decimal form
+static KeyframeIndex makeIndex(uintmax_t videoSize, std::time_t videoTime) {
+    return KeyframeIndex(videoSize, videoTime, 601, 250, 
+            {0, 250 * 1000 / 29.97, 500 * 1000 / 29.97});
+}
+
+static bool isSame(const KeyframeIndex& a, const KeyframeIndex& b) {
+    return a.getVideoSize() == b.getVideoSize() && a.getVideoTime() == b.getVideoTime() &&
+            a.getFrameCount() == b.getFrameCount() && a.getInterval() == b.getInterval() &&
+            a.getPositionsMsec() == b.getPositionsMsec();
+}
+
+static void writeIndex(const string& filename, const KeyframeIndex& index) {
+    KeyframeIndexFileWriter writer(filename);
+    CHECK(writer.write(index));
+}
+
+static void writeText(const string& filename, const string& content) {
+    ofstream os(filename);
+    os << content;
+}
+
+static void testRoundTrip(const string& directory) {
+    string filename = directory + "/index.keyframes";
+    KeyframeIndex index = makeIndex(123456789012, 1500000000);
+    writeIndex(filename, index);
+    CHECK(isSame(KeyframeIndexFileReader(filename).getNext(), index));
+    
+    // Last seek point missing
+    writeText(filename, "1,2,601,250\n0\n8341.6666666666661\n");
+    CHECK_THROWS(KeyframeIndexFileReader(filename).getNext());
+    writeText(filename, "1,2,601,0\n");
+    CHECK_THROWS(KeyframeIndexFileReader(filename).getNext());
+    writeText(filename, "");
+    CHECK_THROWS(KeyframeIndexFileReader(filename).getNext());
+    CHECK_THROWS(KeyframeIndexFileReader(directory + "/missing.keyframes").getNext());
+}
+
+static void testSeekFrames() {
+    KeyframeIndex index = makeIndex(1, 1);
+    CHECK(index.findSeekFrame(-1) == 0 && index.findSeekFrame(0) == 0);
+    CHECK(index.findSeekFrame(249) == 0 && index.findSeekFrame(250) == 250);
+    CHECK(index.findSeekFrame(499) == 250 && index.findSeekFrame(600) == 500);
+    // Past end of video, last seek point
+    CHECK(index.findSeekFrame(10000) == 500);
+    CHECK(KeyframeIndex().findSeekFrame(1000) == 0);
+    
+    double position = 250 * 1000 / 29.97;
+    CHECK(index.isAt(250, position, 1) && index.isAt(250, position + 0.5, 1));
+    CHECK(!index.isAt(250, position + 2, 1) && !index.isAt(250, position - 2, 1));
+    // Not seek point, or after last one
+    CHECK(!index.isAt(100, position, 1000) && !index.isAt(750, position, 1000));
+}
+
+static void testCache(const string& directory) {
+    // Cache is used only while it matches file, which needn't be video 
+    // for that
+    string videoFilename = directory + "/video.avi";
+    writeText(videoFilename, "not a video");
+    std::time_t videoTime = boost::filesystem::last_write_time(videoFilename);
+    KeyframeIndex index = makeIndex(boost::filesystem::file_size(videoFilename), videoTime);
+    CHECK(index.matches(videoFilename));
+    writeIndex(KeyframeIndex::getCacheFilename(videoFilename), index);
+    CHECK(isSame(KeyframeIndex::get(videoFilename), index));
+    
+    // Stale cache is rebuilt, which fails for this file
+    boost::filesystem::last_write_time(videoFilename, videoTime + 10);
+    CHECK(!index.matches(videoFilename));
+    CHECK_THROWS(KeyframeIndex::get(videoFilename));
+    
+    writeText(videoFilename, "not a video either");
+    boost::filesystem::last_write_time(videoFilename, videoTime);
+    CHECK(!index.matches(videoFilename));
+    
+    // Incomplete cache is rebuilt too
+    writeText(KeyframeIndex::getCacheFilename(videoFilename), 
+            std::to_string(boost::filesystem::file_size(videoFilename)) + "," 
+            + std::to_string(videoTime) + ",601,250\n0\n");
+    CHECK_THROWS(KeyframeIndex::get(videoFilename));
+    
+    // Building released lock for other processes, even after error
+    int lockFd = open(KeyframeIndex::getLockFilename(videoFilename).c_str(), O_RDWR);
+    CHECK(lockFd >= 0 && flock(lockFd, LOCK_EX | LOCK_NB) == 0);
+    if (lockFd >= 0) {
+        close(lockFd);
+    }
+}
+
+int main(int argc, char** argv) {
+    string directory = gk::test::makeTempDirectory();
+    
+    testRoundTrip(directory);
+    testSeekFrames();
+    testCache(directory);
+    
+    boost::filesystem::remove_all(directory);
+    return gk::test::testResult();
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Line index must give offsets of line starts, must be read from cache only
+ * while cache matches file, and must let time file reader start at any 
+ * frame.
+ */
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include <boost/filesystem.hpp>
+
+#include "lineindex.hpp"
+#include "timefilereader.hpp"
+#include "testcheck.hpp"
+
+using namespace std;
+using namespace gk;
+
+static string directory;
+
+static string writeFile(const string& name, const string& content) {
+    string filename = directory + "/" + name;
+    ofstream os(filename, ios::binary);
+    os << content;
+    return filename;
+}
+
+static vector<int64_t> getOffsets(const LineIndex& index) {
+    vector<int64_t> offsets;
+    for (long line = 1; line <= index.getLineCount(); line++) {
+        offsets.push_back(index.getOffset(line));
+    }
+    return offsets;
+}
+
+/**
+ * Cache that matches size and time of file, but has other offsets.
+ */
+static void writeForgedCache(const string& filename, const vector<uint64_t>& offsets) {
+    LineIndex::Header header;
+    memcpy(header.magic, LineIndex::MAGIC, sizeof (LineIndex::MAGIC));
+    header.fileSize = boost::filesystem::file_size(filename);
+    header.fileTime = boost::filesystem::last_write_time(filename);
+    header.lineCount = offsets.size();
+    
+    ofstream os(LineIndex::getCacheFilename(filename), ios::binary);
+    os.write((const char*) &header, sizeof (LineIndex::Header));
+    os.write((const char*) offsets.data(), offsets.size() * sizeof (uint64_t));
+}
+
+static void testOffsets() {
+    // Line after last new line starts at end of file
+    std::shared_ptr<const LineIndex> index = LineIndex::build(writeFile("a.txt", "10\n200\n3\n"));
+    CHECK(getOffsets(*index) == vector<int64_t>({0, 3, 7, 9}));
+    CHECK(index->getOffset(0) == -1 && index->getOffset(5) == -1);
+    
+    index = LineIndex::build(writeFile("b.txt", "10\n200\n3"));
+    CHECK(getOffsets(*index) == vector<int64_t>({0, 3, 7}));
+    
+    index = LineIndex::build(writeFile("c.txt", ""));
+    CHECK(index->getLineCount() == 0 && index->getOffset(1) == -1);
+    
+    CHECK_THROWS(LineIndex::build(directory + "/missing.txt"));
+}
+
+static void testCache() {
+    string filename = writeFile("cache.txt", "1\n2\n3\n");
+    string cacheFilename = LineIndex::getCacheFilename(filename);
+    
+    CHECK(getOffsets(*LineIndex::get(filename)) == vector<int64_t>({0, 2, 4, 6}));
+    CHECK(boost::filesystem::exists(cacheFilename));
+    
+    // Matching cache is used, so forged offsets come back
+    writeForgedCache(filename, {0, 1});
+    CHECK(getOffsets(*LineIndex::get(filename)) == vector<int64_t>({0, 1}));
+    
+    // Changed time invalidates cache, and cache is rewritten
+    std::time_t time = boost::filesystem::last_write_time(filename);
+    boost::filesystem::last_write_time(filename, time + 10);
+    CHECK(getOffsets(*LineIndex::get(filename)) == vector<int64_t>({0, 2, 4, 6}));
+    CHECK(LineIndex::get(filename)->matches(filename));
+    
+    // Changed size invalidates cache, even in same second
+    writeForgedCache(filename, {0, 1});
+    {
+        ofstream os(filename, ios::binary | ios::app);
+        os << "4\n";
+    }
+    boost::filesystem::last_write_time(filename, time + 10);
+    CHECK(getOffsets(*LineIndex::get(filename)) == vector<int64_t>({0, 2, 4, 6, 8}));
+}
+
+static void testCorruptCache() {
+    string filename = writeFile("corrupt.txt", "1\n2\n");
+    string cacheFilename = LineIndex::getCacheFilename(filename);
+    
+    writeFile("corrupt.txt.lines", "GKLINES0 and some more bytes to fill header");
+    CHECK(getOffsets(*LineIndex::get(filename)) == vector<int64_t>({0, 2, 4}));
+    
+    // Header without offsets
+    writeForgedCache(filename, {0, 1, 2});
+    boost::filesystem::resize_file(cacheFilename, sizeof (LineIndex::Header) + sizeof (uint64_t));
+    CHECK(getOffsets(*LineIndex::get(filename)) == vector<int64_t>({0, 2, 4}));
+    
+    // Count far past end of cache
+    writeForgedCache(filename, {0, 1});
+    {
+        fstream os(cacheFilename, ios::binary | ios::in | ios::out);
+        uint64_t lineCount = UINT64_C(1) << 60;
+        os.seekp(offsetof(LineIndex::Header, lineCount));
+        os.write((const char*) &lineCount, sizeof (lineCount));
+    }
+    CHECK(getOffsets(*LineIndex::get(filename)) == vector<int64_t>({0, 2, 4}));
+    
+    // Rebuilt cache is whole again
+    CHECK(boost::filesystem::file_size(cacheFilename) == 
+            sizeof (LineIndex::Header) + 3 * sizeof (uint64_t));
+}
+
+static void testTimeFileReader() {
+    string filename = writeFile("time.txt", "100\n200\n300\n400\n");
+    
+    TimeFileReader first(filename, 1);
+    CHECK(first.getNext() == 100 && first.getNext() == 200);
+    
+    TimeFileReader third(filename, 3);
+    CHECK(third.getNext() == 300 && third.getNext() == 400);
+    
+    std::shared_ptr<const LineIndex> index = LineIndex::get(filename);
+    TimeFileReader fourth(filename, 4, index);
+    CHECK(fourth.getNext() == 400);
+    
+    TimeFileReader past(filename, 10, index);
+    CHECK(past.getNext() == -1);
+}
+
+int main(int argc, char** argv) {
+    directory = gk::test::makeTempDirectory();
+    
+    testOffsets();
+    testCache();
+    testCorruptCache();
+    testTimeFileReader();
+    
+    boost::filesystem::remove_all(directory);
+    return gk::test::testResult();
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * BoundedQueue must keep FIFO order and lose no values under concurrent
+ * producers and consumers. Pipeline must deliver jobs to ordered stages
+ * in source order and rethrow first exception of any stage, also when
+ * other stages wait on their queues.
+ */
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+
+#include "boundedqueue.hpp"
+#include "pipeline.hpp"
+#include "testcheck.hpp"
+
+using namespace std;
+using namespace gk;
+
+static void testQueueSingleThread() {
+    BoundedQueue<int> queue(5);
+    CHECK(queue.getCapacity() == 8);
+    CHECK(BoundedQueue<int>(1).getCapacity() == 2);
+    
+    int value;
+    CHECK(!queue.tryPop(value));
+    for (int i = 0; i < 8; i++) {
+        CHECK(queue.tryPush(int(i)));
+    }
+    CHECK(!queue.tryPush(8));
+    
+    // Positions wrap around capacity
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 8; i++) {
+            CHECK(queue.tryPop(value) && value == round * 8 + i);
+            CHECK(queue.tryPush(int((round + 1) * 8 + i)));
+        }
+    }
+}
+
+static void testQueueConcurrent() {
+    const int PRODUCERS = 4, CONSUMERS = 4, COUNT = 20000;
+    BoundedQueue<long> queue(16);
+    
+    std::mutex mutex;
+    vector<int> received(PRODUCERS * COUNT, 0);
+    std::atomic<int> consumed(0);
+    std::atomic<bool> ordered(true);
+    
+    vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; p++) {
+        threads.push_back(std::thread([&queue, p]() {
+            for (long i = 0; i < COUNT; i++) {
+                long value = p * COUNT + i;
+                while (!queue.tryPush(std::move(value))) {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (int c = 0; c < CONSUMERS; c++) {
+        threads.push_back(std::thread([&]() {
+            // Values of one producer come to one consumer in push order
+            vector<long> last(PRODUCERS, -1);
+            long value;
+            while (consumed < PRODUCERS * COUNT) {
+                if (!queue.tryPop(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                consumed++;
+                int producer = (int) (value / COUNT);
+                if (value <= last[producer]) {
+                    ordered = false;
+                }
+                last[producer] = value;
+                
+                std::lock_guard<std::mutex> lock(mutex);
+                received[value]++;
+            }
+        }));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    
+    CHECK(ordered);
+    CHECK(std::count(received.begin(), received.end(), 1) == (long) received.size());
+}
+
+static void testPipelineOrder(int parallelism) {
+    const int COUNT = 500;
+    int produced = 0;
+    Pipeline<int> pipeline(4, [&produced](int& job) {
+        if (produced == COUNT) {
+            return false;
+        }
+        job = produced++;
+        return true;
+    });
+    
+    // Parallel stage finishes jobs out of order
+    std::atomic<bool> workerInRange(true);
+    pipeline.addWorkerStage("shuffle", [parallelism, &workerInRange](int& job, int worker) {
+        if (worker < 0 || worker >= parallelism) {
+            workerInRange = false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds((job * 7919) % 200));
+    }, parallelism);
+    
+    vector<int> middle;
+    pipeline.addStage("ordered", [&middle](int& job) {
+        middle.push_back(job);
+    });
+    pipeline.addStage("parallel", [](int& job) {
+        job *= 2;
+    }, parallelism);
+    
+    vector<int> output;
+    pipeline.addStage("output", [&output](int& job) {
+        output.push_back(job);
+    });
+    pipeline.run();
+    
+    CHECK(workerInRange);
+    CHECK((int) middle.size() == COUNT && (int) output.size() == COUNT);
+    bool inOrder = true;
+    for (int i = 0; i < (int) middle.size() && i < (int) output.size(); i++) {
+        inOrder = inOrder && middle[i] == i && output[i] == 2 * i;
+    }
+    CHECK(inOrder);
+}
+
+static void testPipelineError() {
+    int produced = 0;
+    Pipeline<int> pipeline(2, [&produced](int& job) {
+        job = produced++;
+        // Endless source, only error stops pipeline
+        return true;
+    });
+    pipeline.addStage("fail", [](int& job) {
+        if (job == 100) {
+            throw std::runtime_error("stage failed");
+        }
+    }, 3);
+    pipeline.addStage("output", [](int& job) {
+    });
+    
+    bool thrown = false;
+    try {
+        pipeline.run();
+    } catch (std::runtime_error& e) {
+        thrown = string(e.what()) == "stage failed";
+    }
+    CHECK(thrown);
+}
+
+static void testPipelineWaiting() {
+    // Slow source leaves stages waiting on empty queues, slow output 
+    // leaves source waiting on full queue
+    const int COUNT = 40;
+    int produced = 0;
+    Pipeline<int> pipeline(2, [&produced](int& job) {
+        if (produced == COUNT) {
+            return false;
+        }
+        if (produced < COUNT / 2) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        job = produced++;
+        return true;
+    });
+    pipeline.addStage("parallel", [](int& job) {
+        job++;
+    }, 3);
+    
+    vector<int> output;
+    pipeline.addStage("output", [&output](int& job) {
+        if (job > COUNT / 2) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        output.push_back(job);
+    });
+    pipeline.run();
+    
+    bool inOrder = (int) output.size() == COUNT;
+    for (int i = 0; i < (int) output.size(); i++) {
+        inOrder = inOrder && output[i] == i + 1;
+    }
+    CHECK(inOrder);
+}
+
+static void testPipelineErrorWakesWaiting() {
+    // Stages wait on empty queues when source fails
+    int produced = 0;
+    Pipeline<int> pipeline(2, [&produced](int& job) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        if (produced == 3) {
+            throw std::runtime_error("source failed");
+        }
+        job = produced++;
+        return true;
+    });
+    pipeline.addStage("parallel", [](int& job) {
+    }, 3);
+    pipeline.addStage("output", [](int& job) {
+    });
+    
+    bool thrown = false;
+    try {
+        pipeline.run();
+    } catch (std::runtime_error& e) {
+        thrown = string(e.what()) == "source failed";
+    }
+    CHECK(thrown);
+}
+
+static void testPipelineNeedsOrderedLastStage() {
+    Pipeline<int> pipeline(2, [](int& job) {
+        return false;
+    });
+    CHECK_THROWS(pipeline.run());
+    
+    pipeline.addStage("output", [](int& job) {
+    }, 2);
+    CHECK_THROWS(pipeline.run());
+}
+
+int main(int argc, char** argv) {
+    testQueueSingleThread();
+    testQueueConcurrent();
+    testPipelineOrder(1);
+    testPipelineOrder(4);
+    testPipelineError();
+    testPipelineWaiting();
+    testPipelineErrorWakesWaiting();
+    testPipelineNeedsOrderedLastStage();
+    
+    return gk::test::testResult();
+}
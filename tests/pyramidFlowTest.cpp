@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Farneback on shared pyramids must match calcOpticalFlowFarneback() on
+ * whole frame.
+ */
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+
+#include "opticalflow.hpp"
+#include "framepyramid.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+static OpticalFlowData getConfig() {
+    OpticalFlowData config = OpticalFlowData();
+    config.flowType = FARNEBACK;
+    config.pyramidScale = 0.5;
+    config.pyramidLayers = 3;
+    config.windowSize = 15;
+    config.iterationsCount = 3;
+    config.neighbourSize = 5;
+    config.gaussianDeviation = 1.2;
+    config.operationFlags = 0;
+    config.sharedPyramid = true;
+    return config;
+}
+
+static void makeFrames(const Point2d& shift, Mat& prevFrame, Mat& frame) {
+    RNG rng(23);
+    Mat noise(240, 320, CV_8UC1);
+    rng.fill(noise, RNG::UNIFORM, 0, 256);
+    GaussianBlur(noise, prevFrame, Size(0, 0), 2.0);
+    normalize(prevFrame, prevFrame, 0, 255, NORM_MINMAX);
+    
+    Mat translation = (Mat_<double>(2, 3) << 1, 0, shift.x, 0, 1, shift.y);
+    warpAffine(prevFrame, frame, translation, prevFrame.size(), INTER_LINEAR, BORDER_REFLECT);
+}
+
+static void compareWithFarneback(const Point2d& shift) {
+    OpticalFlowData config = getConfig();
+    Mat prevFrame, frame;
+    makeFrames(shift, prevFrame, frame);
+    
+    Mat expected;
+    calcOpticalFlowFarneback(prevFrame, frame, expected,
+            config.pyramidScale,
+            config.pyramidLayers,
+            config.windowSize,
+            config.iterationsCount,
+            config.neighbourSize,
+            config.gaussianDeviation,
+            config.operationFlags);
+    
+    FramePyramid prevPyramid(config.pyramidScale, config.pyramidLayers);
+    FramePyramid pyramid(config.pyramidScale, config.pyramidLayers);
+    prevPyramid.build(prevFrame);
+    pyramid.build(frame);
+    
+    TrackerData trackerData = TrackerData();
+    OpticalFlow opticalFlow(config, trackerData, nullptr);
+    Mat flowAngle, flowMagnitude;
+    opticalFlow.getPolarFlow(prevPyramid, pyramid, Rect2d(), flowAngle, flowMagnitude);
+    const Mat& actual = opticalFlow.getFlow();
+    
+    CHECK(expected.size() == actual.size());
+    if (expected.size() != actual.size()) {
+        return;
+    }
+    
+    // Border is left out, both flows are poor there
+    Rect inside(16, 16, expected.cols - 32, expected.rows - 32);
+    Mat difference = actual(inside) - expected(inside);
+    vector<Mat> channels;
+    split(difference, channels);
+    Mat endpointError;
+    magnitude(channels[0], channels[1], endpointError);
+    
+    // Coarser layers are blurred twice, so flows are close but not equal
+    double meanError = mean(endpointError)[0];
+    cout << "Shift " << shift << ": mean EPE " << meanError << " px" << endl;
+    CHECK(meanError < 0.1);
+    
+    Scalar meanFlow = mean(actual(inside));
+    CHECK(std::abs(meanFlow[0] - shift.x) < 0.25);
+    CHECK(std::abs(meanFlow[1] - shift.y) < 0.25);
+}
+
+int main(int argc, char** argv) {
+    // Large shifts are found only on coarse layers
+    compareWithFarneback(Point2d(1.5, -0.5));
+    compareWithFarneback(Point2d(6.0, 4.0));
+    
+    return gk::test::testResult();
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Quality scheduler must lower quality one level at a time while flow is 
+ * over budget, raise it only well below budget and not more often than 
+ * its delays allow, and stay between minimal and configured quality.
+ */
+
+#include <opencv2/core/core.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "qualityscheduler.hpp"
+#include "opticalflow.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+// 40 ms budget
+static const double TARGET_FPS = 25;
+
+static OpticalFlowData makeConfig() {
+    OpticalFlowData config = OpticalFlowData();
+    config.targetFps = TARGET_FPS;
+    config.iterationsCount = 10;
+    config.pyramidLayers = 5;
+    config.windowSize = 21;
+    config.minQuality.iterationsCount = 2;
+    config.minQuality.pyramidLayers = 1;
+    config.minQuality.windowSize = 5;
+    return config;
+}
+
+static bool isSame(const FlowQuality& a, const FlowQuality& b) {
+    return a.iterationsCount == b.iterationsCount && 
+            a.pyramidLayers == b.pyramidLayers && a.windowSize == b.windowSize;
+}
+
+static bool isWithin(const FlowQuality& quality, const FlowQuality& minQuality, 
+        const FlowQuality& maxQuality) {
+    return quality.iterationsCount >= minQuality.iterationsCount &&
+            quality.iterationsCount <= maxQuality.iterationsCount &&
+            quality.pyramidLayers >= minQuality.pyramidLayers &&
+            quality.pyramidLayers <= maxQuality.pyramidLayers &&
+            quality.windowSize >= minQuality.windowSize &&
+            quality.windowSize <= maxQuality.windowSize;
+}
+
+/**
+ * Feeds same latency count times.
+ * 
+ * @param fewestFramesBetweenChanges Lowered to fewest frames between two 
+ * changes of this call.
+ * @return Number of level changes.
+ */
+static int feed(QualityScheduler& scheduler, double latency, int count, 
+        int& fewestFramesBetweenChanges) {
+    int changes = 0;
+    // Unknown before first change
+    int framesSinceChange = -1;
+    for (int i = 0; i < count; i++) {
+        if (framesSinceChange >= 0) {
+            framesSinceChange++;
+        }
+        int level = scheduler.getLevel();
+        if (scheduler.update(latency)) {
+            changes++;
+            // Only steps of one level
+            CHECK(std::abs(scheduler.getLevel() - level) == 1);
+            if (framesSinceChange >= 0) {
+                fewestFramesBetweenChanges = std::min(fewestFramesBetweenChanges, framesSinceChange);
+            }
+            framesSinceChange = 0;
+        }
+    }
+    return changes;
+}
+
+static void testDegradeAndRecover() {
+    OpticalFlowData config = makeConfig();
+    FlowQuality maxQuality = {config.iterationsCount, config.pyramidLayers, config.windowSize};
+    QualityScheduler scheduler(config);
+    
+    // Starts at configured quality
+    int topLevel = scheduler.getLevel();
+    CHECK(!scheduler.isDegraded());
+    CHECK(isSame(scheduler.getQuality(), maxQuality));
+    
+    // Twice over budget lowers to minimal quality, not below it
+    int fewestFrames = 1000;
+    int changes = feed(scheduler, 80, 200, fewestFrames);
+    CHECK(changes == topLevel);
+    CHECK(scheduler.getLevel() == 0 && scheduler.isDegraded());
+    CHECK(isSame(scheduler.getQuality(), config.minQuality));
+    // Lowering waits a few frames to see effect of last change
+    CHECK(fewestFrames >= 5);
+    
+    // Between headroom and budget quality stays, once smoothed latency 
+    // is below budget
+    feed(scheduler, 35, 50, fewestFrames);
+    int level = scheduler.getLevel();
+    CHECK(feed(scheduler, 35, 300, fewestFrames) == 0);
+    CHECK(scheduler.getLevel() == level);
+    
+    // Well below budget raises to configured quality, slower than it 
+    // lowered
+    fewestFrames = 1000;
+    changes = feed(scheduler, 10, 1000, fewestFrames);
+    CHECK(changes == topLevel - level);
+    CHECK(fewestFrames >= 30);
+    CHECK(scheduler.getLevel() == topLevel && !scheduler.isDegraded());
+    CHECK(isSame(scheduler.getQuality(), maxQuality));
+    CHECK(feed(scheduler, 10, 100, fewestFrames) == 0);
+}
+
+static void testQualityBounds() {
+    OpticalFlowData config = makeConfig();
+    FlowQuality maxQuality = {config.iterationsCount, config.pyramidLayers, config.windowSize};
+    QualityScheduler scheduler(config);
+    
+    // Every level is between minimal and configured quality and not 
+    // better than level above it
+    FlowQuality previous = scheduler.getQuality();
+    bool within = isWithin(previous, config.minQuality, maxQuality);
+    bool monotonic = true;
+    for (int i = 0; i < 200; i++) {
+        if (scheduler.update(1000)) {
+            FlowQuality quality = scheduler.getQuality();
+            within = within && isWithin(quality, config.minQuality, maxQuality);
+            monotonic = monotonic && isWithin(quality, config.minQuality, previous);
+            previous = quality;
+        }
+    }
+    CHECK(within && monotonic);
+    
+    // Minimal quality same as configured one never changes quality
+    config.minQuality = maxQuality;
+    QualityScheduler fixed(config);
+    for (int i = 0; i < 100; i++) {
+        fixed.update(1000);
+    }
+    CHECK(isSame(fixed.getQuality(), maxQuality));
+}
+
+static void testSmoothing() {
+    QualityScheduler scheduler(makeConfig());
+    int fewestFrames = 1000;
+    feed(scheduler, 10, 10, fewestFrames);
+    
+    // Single late frame is smoothed away
+    CHECK(!scheduler.update(45));
+    CHECK(feed(scheduler, 10, 10, fewestFrames) == 0);
+    CHECK(!scheduler.isDegraded());
+}
+
+int main(int argc, char** argv) {
+    testDegradeAndRecover();
+    testQualityBounds();
+    testSmoothing();
+    return gk::test::testResult();
+}
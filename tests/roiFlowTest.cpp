@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Flow calculated only on padded ROI must match flow of full frame 
+ * cropped to ROI.
+ */
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "opticalflow.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+static OpticalFlowData getConfig() {
+    OpticalFlowData config = OpticalFlowData();
+    config.flowType = FARNEBACK;
+    config.pyramidScale = 0.5;
+    config.pyramidLayers = 2;
+    config.windowSize = 9;
+    config.iterationsCount = 2;
+    config.neighbourSize = 5;
+    config.gaussianDeviation = 1.1;
+    config.operationFlags = 0;
+    config.roiFlow = true;
+    config.roiMaxDisplacement = 4;
+    config.canonicalDiagonal = 0;
+    return config;
+}
+
+static void makeFrames(const Point2d& shift, Mat& prevFrame, Mat& frame) {
+    RNG rng(17);
+    Mat noise(240, 320, CV_8UC1);
+    rng.fill(noise, RNG::UNIFORM, 0, 256);
+    GaussianBlur(noise, prevFrame, Size(0, 0), 2.0);
+    normalize(prevFrame, prevFrame, 0, 255, NORM_MINMAX);
+    
+    Mat translation = (Mat_<double>(2, 3) << 1, 0, shift.x, 0, 1, shift.y);
+    warpAffine(prevFrame, frame, translation, prevFrame.size(), INTER_LINEAR, BORDER_REFLECT);
+}
+
+static void compareWithFullFrame(const Rect2d& roi) {
+    TrackerData trackerData = TrackerData();
+    trackerData.trackerUsed = true;
+    
+    Mat prevFrame, frame;
+    makeFrames(Point2d(2.5, 1.5), prevFrame, frame);
+    Mat flowAngle, flowMagnitude;
+    
+    OpticalFlow fullFlow(getConfig(), trackerData, nullptr);
+    fullFlow.getPolarFlow(prevFrame.getUMat(ACCESS_READ), frame.getUMat(ACCESS_READ), 
+            roi, flowAngle, flowMagnitude);
+    Mat expected = fullFlow.getFlow().clone();
+    
+    OpticalFlow roiFlow(getConfig(), trackerData, nullptr);
+    roiFlow.getPolarRoiFlow(prevFrame, frame, roi, flowAngle, flowMagnitude);
+    Mat actual = roiFlow.getFlow().clone();
+    
+    CHECK(!expected.empty());
+    CHECK(expected.size() == actual.size());
+    if (expected.empty() || expected.size() != actual.size()) {
+        return;
+    }
+    
+    Mat difference = actual - expected;
+    vector<Mat> channels;
+    split(difference, channels);
+    Mat endpointError;
+    magnitude(channels[0], channels[1], endpointError);
+    
+    double maxError;
+    minMaxLoc(endpointError, nullptr, &maxError);
+    double meanError = mean(endpointError)[0];
+    cout << "ROI " << roi << ": mean EPE " << meanError << " px, max EPE " << maxError << " px" << endl;
+    CHECK(meanError < 0.05);
+    CHECK(maxError < 0.5);
+    
+    // Flow itself is close to shift
+    Scalar meanFlow = mean(actual);
+    CHECK(std::abs(meanFlow[0] - 2.5) < 0.5);
+    CHECK(std::abs(meanFlow[1] - 1.5) < 0.5);
+}
+
+static void testMarginGrows() {
+    TrackerData trackerData = TrackerData();
+    OpticalFlowData config = getConfig();
+    int margin = OpticalFlow(config, trackerData, nullptr).getRoiMargin();
+    
+    config.iterationsCount++;
+    CHECK(OpticalFlow(config, trackerData, nullptr).getRoiMargin() > margin);
+    
+    config = getConfig();
+    config.roiMaxDisplacement++;
+    CHECK(OpticalFlow(config, trackerData, nullptr).getRoiMargin() > margin);
+    
+    config = getConfig();
+    config.pyramidLayers++;
+    CHECK(OpticalFlow(config, trackerData, nullptr).getRoiMargin() > margin);
+}
+
+int main(int argc, char** argv) {
+    testMarginGrows();
+    
+    // Inside frame, padded ROI touches border and ROI at border
+    compareWithFullFrame(Rect2d(136, 96, 48, 40));
+    compareWithFullFrame(Rect2d(100, 60, 60, 50));
+    compareWithFullFrame(Rect2d(0, 0, 64, 48));
+    
+    return gk::test::testResult();
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SelectionPlan must split frames to contiguous shards and mark frames 
+ * that camera has to decode, and survive round trip through plan file.
+ */
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <exception>
+
+#include <boost/filesystem.hpp>
+
+#include "selectionplanfile.hpp"
+#include "testcheck.hpp"
+
+using namespace std;
+using namespace gk;
+
+static SelectionPlan makePlan(long firstFrame, const vector<int>& cameras) {
+    SelectionPlan plan(firstFrame);
+    for (int camera : cameras) {
+        plan.add(camera);
+    }
+    return plan;
+}
+
+static void testShards() {
+    SelectionPlan plan = makePlan(1, vector<int>(10, 0));
+    long firstFrame, lastFrame;
+    
+    // First frameCount % shardCount shards get one frame more
+    plan.getShard(3, 0, firstFrame, lastFrame);
+    CHECK(firstFrame == 1 && lastFrame == 4);
+    plan.getShard(3, 1, firstFrame, lastFrame);
+    CHECK(firstFrame == 5 && lastFrame == 7);
+    plan.getShard(3, 2, firstFrame, lastFrame);
+    CHECK(firstFrame == 8 && lastFrame == 10);
+    
+    // Shards cover plan without gaps and overlaps
+    for (int shardCount = 1; shardCount <= 13; shardCount++) {
+        long expectedFirst = 1;
+        for (int shardIndex = 0; shardIndex < shardCount; shardIndex++) {
+            plan.getShard(shardCount, shardIndex, firstFrame, lastFrame);
+            CHECK(firstFrame == expectedFirst);
+            CHECK(lastFrame >= firstFrame - 1);
+            CHECK(lastFrame - firstFrame <= 10 / shardCount);
+            expectedFirst = lastFrame + 1;
+        }
+        CHECK(expectedFirst == 11);
+    }
+    
+    CHECK_THROWS(plan.getShard(0, 0, firstFrame, lastFrame));
+    CHECK_THROWS(plan.getShard(3, 3, firstFrame, lastFrame));
+    CHECK_THROWS(plan.getShard(3, -1, firstFrame, lastFrame));
+}
+
+static void testNeededFrames() {
+    // Frames 5 to 9
+    SelectionPlan plan = makePlan(5, {0, 0, 1, 1, 0});
+    
+    // Frame before plan is needed only as previous frame of first frame,
+    // frames before it are outside plan
+    vector<bool> camera1 = plan.getNeededFrames(1, 3);
+    CHECK(camera1 == vector<bool>({true, false, false, true, true, true, false}));
+    
+    vector<bool> camera0 = plan.getNeededFrames(0, 5);
+    CHECK(camera0 == vector<bool>({true, true, false, true, true}));
+    
+    CHECK(plan.getNeededFrames(0, 4) == vector<bool>({true, true, true, false, true, true}));
+    CHECK(plan.getNeededFrames(0, 12).empty());
+    
+    CHECK(plan.getSelected(7) == 1);
+    CHECK(!plan.contains(4) && !plan.contains(10));
+    CHECK_THROWS(plan.getSelected(10));
+}
+
+static void testLastFrame() {
+    SelectionPlan plan = makePlan(5, {0, 0, 1, 1, 0});
+    CHECK(plan.getLastFrame() == 9);
+    CHECK(plan.contains(plan.getLastFrame()) && !plan.contains(plan.getLastFrame() + 1));
+    CHECK(SelectionPlan(5).getLastFrame() == 4);
+    
+    long firstFrame, lastFrame;
+    plan.getShard(2, 1, firstFrame, lastFrame);
+    CHECK(lastFrame == plan.getLastFrame());
+    
+    // Loop of scene flow main, flow of f-th loop is synced with frame f + 1,
+    // must stop at end of plan instead of asking plan for frame after it
+    int loops = 0;
+    bool throws = false;
+    for (int f = 4;; f++) {
+        if (std::max(f, 1) + 1 > plan.getLastFrame()) {
+            break;
+        }
+        try {
+            plan.getSelected(std::max(f, 1) + 1);
+        } catch (std::exception& e) {
+            throws = true;
+        }
+        loops++;
+    }
+    CHECK(!throws && loops == 5);
+}
+
+static void testFile(const string& directory) {
+    string filename = directory + "/plan.txt";
+    SelectionPlan plan = makePlan(3, {2, 2, 0, 1, 1, 1, 2});
+    {
+        SelectionPlanFileWriter writer(filename);
+        CHECK(writer.write(plan));
+    }
+    
+    SelectionPlan read = SelectionPlanFileReader(filename).getNext();
+    CHECK(read.getFirstFrame() == 3 && read.getFrameCount() == 7);
+    bool same = true;
+    for (long frame = 3; frame < 10 && read.getFrameCount() == 7; frame++) {
+        same = same && read.getSelected(frame) == plan.getSelected(frame);
+    }
+    CHECK(same);
+    
+    // Switch before first frame and wrong frame count
+    {
+        ofstream os(filename);
+        os << "3,7" << endl << "2,1" << endl;
+    }
+    CHECK_THROWS(SelectionPlanFileReader(filename).getNext());
+    {
+        ofstream os(filename);
+        os << "3,7" << endl << "3,1" << endl << "12,0" << endl;
+    }
+    CHECK_THROWS(SelectionPlanFileReader(filename).getNext());
+}
+
+int main(int argc, char** argv) {
+    string directory = gk::test::makeTempDirectory();
+    
+    testShards();
+    testNeededFrames();
+    testLastFrame();
+    testFile(directory);
+    
+    boost::filesystem::remove_all(directory);
+    return gk::test::testResult();
+}
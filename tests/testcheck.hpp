@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TESTCHECK_HPP
+#define TESTCHECK_HPP
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <exception>
+
+#include <boost/filesystem.hpp>
+
+/*
+ * Simple C++ Test Suite
+ * 
+ * CHECK prints failed condition and test goes on, so one run reports 
+ * every failure. main() returns testResult().
+ */
+
+namespace gk {
+    namespace test {
+
+        inline int& failureCount() {
+            static int count = 0;
+            return count;
+        }
+
+        inline void check(bool condition, const char* text, const char* file, int line) {
+            if (!condition) {
+                std::cerr << file << ":" << line << ": CHECK(" << text << ") failed" << std::endl;
+                failureCount()++;
+            }
+        }
+
+        inline int testResult() {
+            if (failureCount() > 0) {
+                std::cerr << failureCount() << " checks failed." << std::endl;
+                return EXIT_FAILURE;
+            }
+            std::cout << "All checks passed." << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        /**
+         * New empty directory for files of one test.
+         */
+        inline std::string makeTempDirectory() {
+            boost::filesystem::path directory = boost::filesystem::temp_directory_path() /
+                    boost::filesystem::unique_path("ff-test-%%%%-%%%%");
+            boost::filesystem::create_directories(directory);
+            return directory.string();
+        }
+    }
+}
+
+#define CHECK(condition) gk::test::check((condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_THROWS(statement) \
+    do { \
+        bool thrown = false; \
+        try { statement; } catch (std::exception&) { thrown = true; } \
+        gk::test::check(thrown, #statement " throws", __FILE__, __LINE__); \
+    } while (false)
+
+#endif /* TESTCHECK_HPP */
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * ThreadPool must run every task once, wait for all of them and rethrow 
+ * first exception, and stay usable after exception.
+ */
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+#include "threadpool.hpp"
+#include "testcheck.hpp"
+
+using namespace std;
+using namespace gk;
+
+static void testEveryTaskOnce(int threadCount) {
+    ThreadPool pool(threadCount);
+    CHECK(pool.getThreadCount() == threadCount);
+    
+    for (size_t count : {1, 3, 100}) {
+        vector<std::atomic<int> > calls(count);
+        for (auto& call : calls) {
+            call = 0;
+        }
+        pool.run(count, [&calls](size_t i) {
+            calls[i]++;
+        });
+        
+        bool once = true;
+        for (auto& call : calls) {
+            once = once && call == 1;
+        }
+        CHECK(once);
+    }
+    
+    // Nothing to do
+    pool.run(0, [](size_t i) {
+        throw std::runtime_error("no task expected");
+    });
+}
+
+static void testException() {
+    ThreadPool pool(3);
+    std::atomic<int> done(0);
+    
+    bool thrown = false;
+    try {
+        pool.run(50, [&done](size_t i) {
+            if (i == 10) {
+                throw std::runtime_error("task failed");
+            }
+            done++;
+        });
+    } catch (std::runtime_error& e) {
+        thrown = string(e.what()) == "task failed";
+    }
+    CHECK(thrown);
+    // Barrier holds also when task throws
+    CHECK(done == 49);
+    
+    // Error of last run is not rethrown again
+    done = 0;
+    pool.run(20, [&done](size_t i) {
+        done++;
+    });
+    CHECK(done == 20);
+}
+
+static void testThreadInit() {
+    std::mutex mutex;
+    std::set<int> indexes;
+    {
+        ThreadPool pool(4, [&mutex, &indexes](int index) {
+            std::lock_guard<std::mutex> lock(mutex);
+            indexes.insert(index);
+        });
+        pool.run(8, [](size_t i) {
+        });
+    }
+    CHECK(indexes == std::set<int>({0, 1, 2, 3}));
+}
+
+int main(int argc, char** argv) {
+    testEveryTaskOnce(0);
+    testEveryTaskOnce(1);
+    testEveryTaskOnce(4);
+    testException();
+    testThreadInit();
+    
+    return gk::test::testResult();
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tracker files must load into same boxes as line by line reading did, and 
+ * malformed lines must throw with their line number.
+ */
+
+#include <opencv2/core/core.hpp>
+
+#include <string>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include "trackerstore.hpp"
+#include "exception.hpp"
+#include "testcheck.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace gk;
+
+static string directory;
+
+static string writeFile(const string& name, const string& content) {
+    string filename = directory + "/" + name;
+    ofstream os(filename, ios::binary);
+    os << content;
+    return filename;
+}
+
+static bool isSame(const Rect2d& box, double x, double y, double width, double height) {
+    return box.x == x && box.y == y && box.width == width && box.height == height;
+}
+
+/**
+ * @return Whether loading content throws with given line in message.
+ */
+static bool throwsOnLine(const string& content, const bool hasConfidence, const long line) {
+    string filename = writeFile("malformed.txt", content);
+    try {
+        TrackerStore store(filename, hasConfidence);
+    } catch (Exception& e) {
+        return string(e.what()).find("Line " + std::to_string(line) + " ") != string::npos;
+    }
+    return false;
+}
+
+static void testOpticalFlow() {
+    string filename = writeFile("of.txt", "1.5,2,3e1,-4\r\n10, 20 ,30,40\n\n \n");
+    TrackerStore store(filename, false);
+    CHECK(store.getFrameCount() == 2);
+    CHECK(isSame(store.get(1), 1.5, 2, 30, -4));
+    CHECK(isSame(store.get(2), 10, 20, 30, 40));
+    // Frames before 1 are frame 1, frames after end are empty
+    CHECK(isSame(store.get(0), 1.5, 2, 30, -4));
+    CHECK(isSame(store.get(3), 0, 0, 0, 0));
+    CHECK(store.isConfident(2) && !store.isConfident(3));
+}
+
+static void testSceneFlow() {
+    // No newline at end of last line
+    string filename = writeFile("sf.txt", "1,2,3,4,0\n5,6,7,8,1\n9,10,11,12,0.5");
+    TrackerStore store(filename, true);
+    CHECK(store.getFrameCount() == 3);
+    CHECK(store.isConfident(1) && isSame(store.get(1), 1, 2, 3, 4));
+    CHECK(!store.isConfident(2) && isSame(store.get(2), 0, 0, 0, 0));
+    // Confidence is truncated, as stoi() did
+    CHECK(store.isConfident(3) && isSame(store.get(3), 9, 10, 11, 12));
+}
+
+static void testEmpty() {
+    TrackerStore store(writeFile("empty.txt", ""), true);
+    CHECK(store.getFrameCount() == 0);
+    CHECK(isSame(store.get(1), 0, 0, 0, 0));
+    CHECK(!store.isConfident(1));
+    
+    CHECK_THROWS(TrackerStore(directory + "/missing.txt", false));
+}
+
+static void testMalformed() {
+    CHECK(throwsOnLine("1,2,3,4\n1,2,3\n", false, 2));
+    CHECK(throwsOnLine("1,2,3,4\n1,2,3,4\n1,2,3,4,5\n", false, 3));
+    CHECK(throwsOnLine("1,2,3,4\n", true, 1));
+    CHECK(throwsOnLine("1,2,x,4\n", false, 1));
+    CHECK(throwsOnLine("1,2,3,4\n\n1,2,3,4\n", false, 2));
+    CHECK(throwsOnLine("1,2,3,4e\n", false, 1));
+    CHECK(throwsOnLine("1;2;3;4\n", false, 1));
+}
+
+int main(int argc, char** argv) {
+    directory = gk::test::makeTempDirectory();
+    
+    testOpticalFlow();
+    testSceneFlow();
+    testEmpty();
+    testMalformed();
+    
+    boost::filesystem::remove_all(directory);
+    return gk::test::testResult();
+}
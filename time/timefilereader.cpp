@@ -30,6 +30,17 @@ TimeFileReader::TimeFileReader(const std::string& filename, const long startFram
     goToLine(is, this->startFrame);   
 }
 
+TimeFileReader::TimeFileReader(const std::string& filename, const long startFrame,
+        const std::shared_ptr<const LineIndex>& lineIndex)
+: BaseFileReader<long>(filename, lineIndex) {
+    
+    this->startFrame = startFrame;
+    if (this->startFrame <= 1) {
+        this->startFrame = 1;
+    }
+    goToLine(is, this->startFrame);   
+}
+
 long TimeFileReader::getNext(){
     if(isGood()){
         is >> timeStamp;
@@ -32,6 +32,12 @@ namespace gk {
     public:
         TimeFileReader(const std::string& filename, const long startFrame);
 
+        /**
+         * @param lineIndex Index of file, shared by readers of same file.
+         */
+        TimeFileReader(const std::string& filename, const long startFrame,
+                const std::shared_ptr<const LineIndex>& lineIndex);
+
         long getNext() override;
 
     };
@@ -34,13 +34,35 @@ VideoTimer::VideoTimer(std::shared_ptr<VideoCapture> videoCapture,
 : BaseTimer(timeToShowUser),
 videoCapture(videoCapture),
 maxFps(0.0),
+startFrames(0.0),
+startCompletion(0.0),
 selectionSeconds(selectionSeconds) {
 
     selectionMilliSeconds = selectionSeconds * 1000.0;
 }
 
+VideoTimer::VideoTimer(std::shared_ptr<FrameDecoder> decoder,
+        double timeToShowUser,
+        double selectionSeconds)
+: BaseTimer(timeToShowUser),
+decoder(decoder),
+maxFps(0.0),
+startFrames(0.0),
+startCompletion(0.0),
+selectionSeconds(selectionSeconds) {
+
+    selectionMilliSeconds = selectionSeconds * 1000.0;
+}
+
+double VideoTimer::getProperty(int propId) {
+    if (decoder) {
+        return decoder->get(propId);
+    }
+    return videoCapture->get(propId);
+}
+
 string VideoTimer::getVideoTime() {
-    int milliseconds = (int) videoCapture->get(CAP_PROP_POS_MSEC);
+    int milliseconds = (int) getProperty(CAP_PROP_POS_MSEC);
     int hundrets = milliseconds % 1000;
     int seconds = (milliseconds / 1000) % 60;
     int minutes = (milliseconds / (1000 * 60)) % 60;
@@ -57,6 +79,8 @@ string VideoTimer::getVideoTime() {
 
 void VideoTimer::start() {
     BaseTimer::start();
+    startFrames = getProperty(CAP_PROP_POS_FRAMES);
+    startCompletion = calculateCompletion();
 
     if (selectionSeconds > 0) {
         this->startTimeToSelect();
@@ -67,7 +91,7 @@ bool VideoTimer::isTimeToSelect() {
     if (selectionMilliSeconds > 0) {
         //time(&selectTimeEnd); // get current time
         //double timeDifference = difftime(selectTimeEnd, selectTimeStart);
-        selectTimeEnd = videoCapture->get(CAP_PROP_POS_MSEC);
+        selectTimeEnd = getProperty(CAP_PROP_POS_MSEC);
         double timeDifference = selectTimeEnd - selectTimeStart;
 
         if (timeDifference > selectionMilliSeconds) {
@@ -85,7 +109,7 @@ bool VideoTimer::isTimeToSelect() {
 
 void VideoTimer::startTimeToSelect() {
     //time(&selectTimeStart); // Restart timer
-    selectTimeStart = videoCapture->get(CAP_PROP_POS_MSEC);
+    selectTimeStart = getProperty(CAP_PROP_POS_MSEC);
 }
 
 void VideoTimer::restartTimeToSelect() {
@@ -105,15 +129,15 @@ string VideoTimer::getCompletion() {
 }
 
 double VideoTimer::calculateCompletion() {
-    double frameCount = videoCapture->get(CAP_PROP_FRAME_COUNT);
-    double nextFrameIndex = videoCapture->get(CAP_PROP_POS_FRAMES);
+    double frameCount = getProperty(CAP_PROP_FRAME_COUNT);
+    double nextFrameIndex = getProperty(CAP_PROP_POS_FRAMES);
     return cvRound((nextFrameIndex / frameCount)*10000.0) / 100.0;
 }
 
 string VideoTimer::getEstimatedTime() {
     double completion = calculateCompletion();
     double timeDifference = calculateElapsedTime();
-    double speed = completion / timeDifference;
+    double speed = (completion - startCompletion) / timeDifference;
     double estimated = (100 - completion) / speed;
 
     int estimatedMillis = (int) (estimated * 1000) % 1000;
@@ -132,7 +156,7 @@ string VideoTimer::getEstimatedTime() {
 }
 
 string VideoTimer::getFps() {
-    double frameCount = videoCapture->get(CAP_PROP_POS_FRAMES);
+    double frameCount = getProperty(CAP_PROP_POS_FRAMES) - startFrames;
     double elapsedTime = calculateElapsedTime();
     double fps = frameCount / calculateElapsedTime();
 
@@ -160,5 +184,5 @@ string VideoTimer::getMaxFps() {
 }
 
 bool VideoTimer::isRealTime() {
-    return maxFps >= videoCapture->get(CAP_PROP_FPS);
+    return maxFps >= getProperty(CAP_PROP_FPS);
 }
@@ -27,6 +27,7 @@
 #include <memory>
 
 #include "basetimer.hpp"
+#include "framedecoder.hpp"
 
 using namespace cv;
 using namespace std;
@@ -36,6 +37,8 @@ namespace gk {
     class VideoTimer : public BaseTimer {
     private:
         std::shared_ptr<VideoCapture> videoCapture;
+        // Used instead of videoCapture when video is decoded ahead
+        std::shared_ptr<FrameDecoder> decoder;
 
         double selectTimeStart, selectTimeEnd;
 
@@ -43,12 +46,19 @@ namespace gk {
         double selectionMilliSeconds;
 
         double maxFps;
+        
+        // Position when timer started, video may start after seek
+        double startFrames;
+        double startCompletion;
 
         double calculateCompletion();
         
+        double getProperty(int propId);
+        
     public:
         VideoTimer(std::shared_ptr<VideoCapture> videoCapture, double timeToShowUser);
         VideoTimer(std::shared_ptr<VideoCapture> videoCapture, double timeToShowuser, double selectionSeconds);
+        VideoTimer(std::shared_ptr<FrameDecoder> decoder, double timeToShowUser, double selectionSeconds);
 
         string getVideoTime();
 
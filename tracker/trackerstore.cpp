@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trackerstore.hpp"
+
+using namespace gk;
+
+TrackerStore::TrackerStore(const string& filename, const bool hasConfidence)
+: hasConfidence(hasConfidence) {
+    
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw Exception(__FILE__, __LINE__, "Could not open tracker file " + filename);
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        ::close(fd);
+        throw Exception(__FILE__, __LINE__, "Could not read tracker file " + filename);
+    }
+    if (status.st_size == 0) {
+        ::close(fd);
+        return;
+    }
+    
+    size_t size = status.st_size;
+    void* address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw Exception(__FILE__, __LINE__, "Could not map tracker file " + filename);
+    }
+    madvise(address, size, MADV_SEQUENTIAL);
+    
+    try {
+        const char* begin = (const char*) address;
+        parse(filename, begin, begin + size);
+    } catch (...) {
+        munmap(address, size);
+        throw;
+    }
+    munmap(address, size);
+}
+
+bool TrackerStore::parseNumber(const char*& p, const char* end, float& value) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    
+    double number = 0;
+    int digits = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+        number = number * 10 + (*p - '0');
+    }
+    if (p < end && *p == '.') {
+        double scale = 0.1;
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+            number += (*p - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+    
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = *p == '-';
+            p++;
+        }
+        int exponent = 0;
+        int exponentDigits = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++, exponentDigits++) {
+            exponent = exponent * 10 + (*p - '0');
+        }
+        if (exponentDigits == 0) {
+            return false;
+        }
+        number *= std::pow(10.0, negativeExponent ? -exponent : exponent);
+    }
+    
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    value = (float) (negative ? -number : number);
+    return true;
+}
+
+void TrackerStore::parse(const string& filename, const char* begin, const char* end) {
+    int columnCount = hasConfidence ? 5 : 4;
+    float values[5];
+    
+    // Trailing empty lines are not frames
+    while (end > begin && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ')) {
+        end--;
+    }
+    
+    const char* p = begin;
+    long line = 1;
+    while (p < end) {
+        int column = 0;
+        for (; column < columnCount; column++) {
+            if (!parseNumber(p, end, values[column])) {
+                break;
+            }
+            if (column < columnCount - 1) {
+                if (p >= end || *p != ',') {
+                    column++;
+                    break;
+                }
+                p++;
+            }
+        }
+        if (column != columnCount || (p < end && *p != '\n')) {
+            throw Exception(__FILE__, __LINE__, "Check tracker's bounding boxes file " + filename 
+                    + ". Line " + std::to_string(line) + " should have " 
+                    + std::to_string(columnCount) + " numbers.");
+        }
+        p++;
+        line++;
+        
+        xs.push_back(values[0]);
+        ys.push_back(values[1]);
+        widths.push_back(values[2]);
+        heights.push_back(values[3]);
+        if (hasConfidence) {
+            // Truncated, as stoi() read it
+            confidences.push_back((int) values[4]);
+        }
+    }
+}
+
+long TrackerStore::getFrameCount() const {
+    return xs.size();
+}
+
+Rect2d TrackerStore::get(const long frame) const {
+    long index = std::max(frame, 1L) - 1;
+    if (index >= (long) xs.size() || !isConfident(frame)) {
+        return Rect2d();
+    }
+    return Rect2d(xs[index], ys[index], widths[index], heights[index]);
+}
+
+bool TrackerStore::isConfident(const long frame) const {
+    long index = std::max(frame, 1L) - 1;
+    if (index >= (long) xs.size()) {
+        return false;
+    }
+    return !hasConfidence || confidences[index] == 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACKERSTORE_HPP
+#define TRACKERSTORE_HPP
+
+#include <opencv2/core/core.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "exception.hpp"
+
+using namespace std;
+using namespace cv;
+
+namespace gk {
+
+    /**
+     * Whole tracker file loaded once into columns, so box of any frame is
+     * found without reading file again. Line n is frame n, as with 
+     * startFrame of tracker files.
+     * 
+     * Optical flow tracker files have x, y, width and height. Scene flow
+     * tracker files add confidence, where 0 is confident, and boxes that 
+     * aren't confident are empty. File is mapped to memory while it is 
+     * parsed. Malformed lines throw.
+     */
+    class TrackerStore {
+    private:
+        bool hasConfidence;
+        vector<float> xs;
+        vector<float> ys;
+        vector<float> widths;
+        vector<float> heights;
+        vector<int> confidences;
+
+        static bool parseNumber(const char*& p, const char* end, float& value);
+
+        void parse(const string& filename, const char* begin, const char* end);
+
+    public:
+        /**
+         * @param hasConfidence File has confidence column, as scene flow 
+         * tracker files.
+         */
+        TrackerStore(const string& filename, const bool hasConfidence);
+
+        long getFrameCount() const;
+
+        /**
+         * @return Box of frame, empty if it isn't confident or frame is 
+         * after end of file. Frames before 1 are frame 1.
+         */
+        Rect2d get(const long frame) const;
+
+        bool isConfident(const long frame) const;
+    };
+}
+
+#endif /* TRACKERSTORE_HPP */
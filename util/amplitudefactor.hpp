@@ -28,10 +28,10 @@ namespace gk{
     public:
         AmplitudeFactor(float diagonal);
         void scale(cv::Mat& magnitude, const cv::Rect2d& roi ) const;
+        float getFactor( const cv::Rect2d& roi ) const;
         
     private:
         float diagonal;      
-        float getFactor( const cv::Rect2d& roi ) const;
         float calculateDiagonal( const cv::Rect2d& roi ) const;
     };
 }
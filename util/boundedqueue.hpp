@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOUNDEDQUEUE_HPP
+#define BOUNDEDQUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace gk {
+
+    /**
+     * Lock-free bounded multi-producer multi-consumer queue (D. Vyukov).
+     * Every cell has sequence number, which tells producers and consumers
+     * whether cell is free or full, so only one compare and swap is 
+     * needed per push or pop.
+     * 
+     * Capacity is rounded up to power of two.
+     */
+    template<typename T>
+    class BoundedQueue {
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        // Keep positions on own cache lines
+        static const size_t CACHE_LINE = 64;
+
+        std::unique_ptr<Cell[]> cells;
+        size_t mask;
+        char padding0[CACHE_LINE];
+        std::atomic<size_t> pushPosition;
+        char padding1[CACHE_LINE];
+        std::atomic<size_t> popPosition;
+        char padding2[CACHE_LINE];
+
+    public:
+        BoundedQueue(size_t capacity);
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        /**
+         * @return False if queue is full.
+         */
+        bool tryPush(T&& value);
+
+        /**
+         * @return False if queue is empty.
+         */
+        bool tryPop(T& value);
+
+        size_t getCapacity() const;
+    };
+
+    template<typename T>
+    BoundedQueue<T>::BoundedQueue(size_t capacity)
+    : pushPosition(0), popPosition(0) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        mask = size - 1;
+
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    template<typename T>
+    bool BoundedQueue<T>::tryPush(T&& value) {
+        size_t position = pushPosition.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+            if (difference == 0) {
+                // Cell is free, claim it
+                if (pushPosition.compare_exchange_weak(position, position + 1,
+                        std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // Cell still holds value from previous round
+                return false;
+            } else {
+                position = pushPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template<typename T>
+    bool BoundedQueue<T>::tryPop(T& value) {
+        size_t position = popPosition.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t) sequence - (intptr_t) (position + 1);
+
+            if (difference == 0) {
+                // Cell is full, claim it
+                if (popPosition.compare_exchange_weak(position, position + 1,
+                        std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = popPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template<typename T>
+    size_t BoundedQueue<T>::getCapacity() const {
+        return mask + 1;
+    }
+}
+
+#endif /* BOUNDEDQUEUE_HPP */
+
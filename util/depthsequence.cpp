@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "depthsequence.hpp"
+
+using namespace gk;
+
+DepthSequence::DepthSequence(const string& depthFilename, const long startFrame,
+        const int prefetchDepth, const int prefetchThreads,
+        const vector<bool>& neededFrames)
+: frameNumber(std::max(startFrame, 1L)) {
+    if (DepthContainer::isContainer(depthFilename)) {
+        container = std::make_shared<DepthContainer>(depthFilename);
+    } else {
+        prefetcher = std::make_shared<ImagePrefetcher>(depthFilename, startFrame,
+                prefetchDepth, prefetchThreads, neededFrames, IMREAD_ANYDEPTH);
+    }
+}
+
+bool DepthSequence::getNext(Mat& depth) {
+    if (prefetcher) {
+        bool found = prefetcher->getNext(depth);
+        name = prefetcher->getFilename();
+        return found;
+    }
+    
+    long frame = frameNumber++;
+    name = "frame " + std::to_string(frame) + " of depth container";
+    if (!container->contains(frame)) {
+        return false;
+    }
+    depth = container->getFrame(frame);
+    return true;
+}
+
+const string& DepthSequence::getName() const {
+    return name;
+}
+
+bool DepthSequence::isContainer() const {
+    return (bool) container;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEPTHSEQUENCE_HPP
+#define DEPTHSEQUENCE_HPP
+
+#include <opencv2/core/core.hpp>
+
+#include <string>
+#include <memory>
+
+#include "imageprefetcher.hpp"
+#include "depthcontainer.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Depth frames from PNG sequence or, if path ends with 
+     * DepthContainer::EXTENSION, from depth container. Frames are uint16
+     * in millimeters, PNG frames are decoded ahead by prefetcher and 
+     * container frames are over mapped file.
+     */
+    class DepthSequence {
+    private:
+        std::shared_ptr<ImagePrefetcher> prefetcher;
+        std::shared_ptr<DepthContainer> container;
+        long frameNumber;
+        string name;
+
+    public:
+        /**
+         * @param prefetchDepth PNG frames decoded ahead, 0 decodes them in
+         * getNext().
+         * @param neededFrames PNG frames marked false are returned empty, 
+         * as with ImagePrefetcher.
+         */
+        DepthSequence(const string& depthFilename, const long startFrame = 1,
+                const int prefetchDepth = 0, const int prefetchThreads = 1,
+                const vector<bool>& neededFrames = vector<bool>());
+
+        /**
+         * @return False if next frame doesn't exist.
+         */
+        bool getNext(Mat& depth);
+
+        // PNG filename or container frame of last getNext(), for messages
+        const string& getName() const;
+
+        bool isContainer() const;
+    };
+}
+
+#endif /* DEPTHSEQUENCE_HPP */
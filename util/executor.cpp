@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "executor.hpp"
+
+using namespace gk;
+
+namespace {
+
+    class EmptyLoop : public cv::ParallelLoopBody {
+    public:
+        void operator()(const cv::Range&) const override {
+        }
+    };
+}
+
+Executor::Executor(const ExecutorData& data, int flowWorkers, int cameraThreads)
+: data(data) {
+    
+    firstCameraWorker = std::max(flowWorkers, 0);
+    workerCount = firstCameraWorker + std::max(cameraThreads, 0) + 1;
+
+    coreCount = data.threads;
+    if (coreCount <= 0) {
+        coreCount = std::max((int) std::thread::hardware_concurrency(), 1);
+    }
+
+    if (data.openCvThreads > 0) {
+        openCvThreads = data.openCvThreads;
+    } else if (workerCount > 1) {
+        // Workers share one OpenCV pool, so its threads can't be split 
+        // between them
+        openCvThreads = 1;
+    } else {
+        openCvThreads = coreCount;
+    }
+    cv::setNumThreads(openCvThreads);
+    
+    // Pool threads started later by pinned worker would inherit its slice
+    cv::parallel_for_(cv::Range(0, openCvThreads), EmptyLoop());
+
+    cameraPool = std::make_shared<ThreadPool>(cameraThreads, [this](int index) {
+        pinWorker(firstCameraWorker + index + 1);
+    });
+}
+
+ThreadPool& Executor::getCameraPool() {
+    return *cameraPool;
+}
+
+void Executor::pinCameraThread() const {
+    pinWorker(firstCameraWorker);
+}
+
+void Executor::pinWorker(int worker) const {
+    if (!data.pinThreads) {
+        return;
+    }
+
+    // Slices wrap around when workers need more cores than there are
+    int sliceSize = std::min(openCvThreads, coreCount);
+    int first = (worker % workerCount) * sliceSize;
+
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    for (int i = 0; i < sliceSize; i++) {
+        CPU_SET((first + i) % coreCount, &cores);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof (cores), &cores) != 0) {
+        cerr << "Could not pin worker " << worker << " to cores." << endl;
+    }
+}
+
+int Executor::getCoreCount() const {
+    return coreCount;
+}
+
+int Executor::getWorkerCount() const {
+    return workerCount;
+}
+
+int Executor::getOpenCvThreads() const {
+    return openCvThreads;
+}
+
+void Executor::printSplit() const {
+    cout << "Threads: " << coreCount << " cores, " << workerCount << " workers, "
+            << openCvThreads << " OpenCV threads";
+    if (workerCount > 1) {
+        cout << " shared by workers";
+    }
+    // Calling worker also runs its parallel_for_
+    if (workerCount + openCvThreads - 1 > coreCount) {
+        cout << " (oversubscribed)";
+    }
+    if (data.pinThreads) {
+        cout << ", pinned";
+    }
+    cout << endl;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/core/utility.hpp>
+
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+
+#include "threadpool.hpp"
+#include "exception.hpp"
+
+using namespace std;
+
+namespace gk {
+
+    // Core budget from terminal
+    struct ExecutorData {
+        // Cores to use, 0 for all cores
+        int threads;
+        // Threads of OpenCV pool, -1 for all cores with one worker and 
+        // 1 with more workers
+        int openCvThreads;
+        // Pin every worker to own slice of cores
+        bool pinThreads;
+    };
+
+    /**
+     * Splits cores between our workers, which calculate more frames at 
+     * once (inter-frame), and OpenCV parallel_for_ inside Farneback, 
+     * resize and cvtColor of every frame (intra-frame), so that together
+     * they don't oversubscribe cores. Owns camera thread pool.
+     * 
+     * cv::setNumThreads() sets one pool for whole process, not budget of
+     * every worker. By default it gets all cores when only one worker 
+     * calls OpenCV, and 1 thread when more workers do, so workers use 
+     * cores instead.
+     * 
+     * Flow workers are workers 0 to flowWorkers - 1 and camera threads 
+     * get workers after them, so every thread that runs at the same time
+     * has own slice. With pinning, worker i runs on cores of slice i.
+     * 
+     * OpenCV thread pool is started in constructor, before any thread is
+     * pinned. With pthreads and TBB backends it is one pool shared by all
+     * workers and its threads may run on any core. Only OpenMP backend 
+     * starts team per worker, which inherits slice of worker.
+     */
+    class Executor {
+    private:
+        ExecutorData data;
+        int coreCount;
+        int workerCount;
+        int firstCameraWorker;
+        int openCvThreads;
+        std::shared_ptr<ThreadPool> cameraPool;
+
+    public:
+        /**
+         * @param flowWorkers Threads calculating flow of frame pairs at 
+         * once, 0 if camera threads calculate flow.
+         * @param cameraThreads Threads of camera pool besides calling 
+         * thread. Calling thread is worker flowWorkers and pool thread i is
+         * worker flowWorkers + i + 1.
+         */
+        Executor(const ExecutorData& data, int flowWorkers, int cameraThreads);
+
+        ThreadPool& getCameraPool();
+
+        /**
+         * Pins calling thread of camera pool, if pinning is enabled.
+         */
+        void pinCameraThread() const;
+
+        /**
+         * Pins calling thread to cores of slice of worker, if pinning is 
+         * enabled.
+         */
+        void pinWorker(int worker) const;
+
+        int getCoreCount() const;
+
+        int getWorkerCount() const;
+
+        int getOpenCvThreads() const;
+
+        void printSplit() const;
+    };
+}
+
+#endif /* EXECUTOR_HPP */
+
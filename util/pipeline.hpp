@@ -0,0 +1,318 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "boundedqueue.hpp"
+#include "exception.hpp"
+
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Runs jobs of type T through source and stages, each on own threads,
+     * connected with lock-free bounded queues. Throughput is limited by 
+     * slowest stage instead of sum of stages. Thread that finds its queue 
+     * full or empty spins shortly and then waits for queue to change.
+     * 
+     * Stage with parallelism 1 gets jobs in source order, stages with
+     * larger parallelism get jobs in any order and must be stateless or 
+     * keep state per worker, see addWorkerStage(). 
+     * Last stage runs on thread that calls run() and must have 
+     * parallelism 1, so output is in source order and can use GUI.
+     * 
+     * First exception of any stage stops pipeline and is rethrown by run().
+     */
+    template<typename T>
+    class Pipeline {
+    public:
+        // Fills job, returns false at end
+        typedef std::function<bool(T&)> Source;
+        typedef std::function<void(T&)> Stage;
+        // Also gets index of worker thread, from 0 to parallelism - 1
+        typedef std::function<void(T&, int)> WorkerStage;
+
+    private:
+        struct Item {
+            long sequence;
+            // Empty job marks end
+            std::shared_ptr<T> job;
+        };
+
+        struct StageInfo {
+            string name;
+            WorkerStage work;
+            int parallelism;
+            std::shared_ptr< BoundedQueue<Item> > input;
+            std::atomic<int> running;
+
+            // Threads waiting for input to change
+            std::mutex waitMutex;
+            std::condition_variable changed;
+            std::atomic<int> waiting;
+        };
+
+        // Spins before waiting thread blocks
+        static const int SPIN_COUNT = 64;
+
+        size_t queueSize;
+        Source source;
+        vector< std::shared_ptr<StageInfo> > stages;
+
+        std::atomic<bool> failed;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        template<typename Operation>
+        bool await(StageInfo& stage, Operation operation);
+        static void notify(StageInfo& stage);
+
+        bool push(StageInfo& stage, Item&& item);
+        bool pop(StageInfo& stage, Item& item);
+        void forward(size_t stage, Item&& item);
+        void finish(size_t stage);
+        void fail();
+
+        void runSource();
+        void runStage(size_t stage, int worker);
+
+    public:
+        Pipeline(size_t queueSize, Source source);
+
+        void addStage(const string& name, Stage work, int parallelism = 1);
+
+        void addWorkerStage(const string& name, WorkerStage work, int parallelism = 1);
+
+        /**
+         * Blocks until source ends and all jobs pass last stage.
+         */
+        void run();
+    };
+
+    template<typename T>
+    Pipeline<T>::Pipeline(size_t queueSize, Source source)
+    : queueSize(queueSize), source(source), failed(false) {
+
+    }
+
+    template<typename T>
+    void Pipeline<T>::addStage(const string& name, Stage work, int parallelism) {
+        addWorkerStage(name, [work](T& job, int) {
+            work(job);
+        }, parallelism);
+    }
+
+    template<typename T>
+    void Pipeline<T>::addWorkerStage(const string& name, WorkerStage work, int parallelism) {
+        auto stage = std::make_shared<StageInfo>();
+        stage->name = name;
+        stage->work = work;
+        stage->parallelism = std::max(parallelism, 1);
+        stage->input = std::make_shared< BoundedQueue<Item> >(queueSize);
+        stage->running = stage->parallelism;
+        stage->waiting = 0;
+        stages.push_back(stage);
+    }
+
+    /**
+     * Retries operation on input of stage until it succeeds or pipeline 
+     * fails, then wakes threads waiting for other end of queue.
+     */
+    template<typename T>
+    template<typename Operation>
+    bool Pipeline<T>::await(StageInfo& stage, Operation operation) {
+        int spins = 0;
+        while (!operation()) {
+            if (failed) {
+                return false;
+            }
+            if (spins < SPIN_COUNT) {
+                spins++;
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(stage.waitMutex);
+            stage.waiting++;
+            // Pairs with fence of notify(): either retry sees change of 
+            // other thread or other thread sees this waiter
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool done = operation();
+            if (!done && !failed) {
+                stage.changed.wait(lock);
+            }
+            stage.waiting--;
+            if (done) {
+                break;
+            }
+        }
+        notify(stage);
+        return true;
+    }
+
+    template<typename T>
+    void Pipeline<T>::notify(StageInfo& stage) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (stage.waiting > 0) {
+            std::lock_guard<std::mutex> lock(stage.waitMutex);
+            stage.changed.notify_all();
+        }
+    }
+
+    template<typename T>
+    bool Pipeline<T>::push(StageInfo& stage, Item&& item) {
+        BoundedQueue<Item>& queue = *stage.input;
+        return await(stage, [&queue, &item] {
+            return queue.tryPush(std::move(item));
+        });
+    }
+
+    template<typename T>
+    bool Pipeline<T>::pop(StageInfo& stage, Item& item) {
+        BoundedQueue<Item>& queue = *stage.input;
+        return await(stage, [&queue, &item] {
+            return queue.tryPop(item);
+        });
+    }
+
+    template<typename T>
+    void Pipeline<T>::forward(size_t stage, Item&& item) {
+        if (stage + 1 < stages.size()) {
+            push(*stages[stage + 1], std::move(item));
+        }
+    }
+
+    template<typename T>
+    void Pipeline<T>::finish(size_t stage) {
+        // Last worker of stage ends every worker of next stage
+        if (--stages[stage]->running == 0 && stage + 1 < stages.size()) {
+            for (int i = 0; i < stages[stage + 1]->parallelism; i++) {
+                push(*stages[stage + 1], Item{-1, nullptr});
+            }
+        }
+    }
+
+    template<typename T>
+    void Pipeline<T>::fail() {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            failed = true;
+        }
+        // Waiters check failed under their lock, so none misses this
+        for (auto& stage : stages) {
+            std::lock_guard<std::mutex> lock(stage->waitMutex);
+            stage->changed.notify_all();
+        }
+    }
+
+    template<typename T>
+    void Pipeline<T>::runSource() {
+        try {
+            for (long sequence = 0; !failed; sequence++) {
+                auto job = std::make_shared<T>();
+                if (!source(*job)) {
+                    break;
+                }
+                push(*stages[0], Item{sequence, job});
+            }
+        } catch (...) {
+            fail();
+        }
+        for (int i = 0; i < stages[0]->parallelism; i++) {
+            push(*stages[0], Item{-1, nullptr});
+        }
+    }
+
+    template<typename T>
+    void Pipeline<T>::runStage(size_t stage, int worker) {
+        StageInfo& info = *stages[stage];
+        bool ordered = info.parallelism == 1;
+
+        // Jobs that came before their predecessors
+        std::map< long, std::shared_ptr<T> > pending;
+        long next = 0;
+
+        try {
+            Item item;
+            while (pop(info, item) && item.job) {
+                if (!ordered) {
+                    info.work(*item.job, worker);
+                    forward(stage, std::move(item));
+                    continue;
+                }
+
+                pending[item.sequence] = item.job;
+                for (auto it = pending.find(next); it != pending.end(); 
+                        it = pending.find(next)) {
+                    info.work(*it->second, worker);
+                    forward(stage, Item{next, it->second});
+                    pending.erase(it);
+                    next++;
+                }
+            }
+        } catch (...) {
+            fail();
+        }
+        finish(stage);
+    }
+
+    template<typename T>
+    void Pipeline<T>::run() {
+        if (stages.empty() || stages.back()->parallelism != 1) {
+            string message = "Pipeline needs last stage with parallelism 1.";
+            throw Exception(__FILE__, __LINE__, message);
+        }
+
+        vector<std::thread> threads;
+        threads.push_back(std::thread(&Pipeline<T>::runSource, this));
+        for (size_t s = 0; s + 1 < stages.size(); s++) {
+            for (int i = 0; i < stages[s]->parallelism; i++) {
+                threads.push_back(std::thread(&Pipeline<T>::runStage, this, s, i));
+            }
+        }
+
+        runStage(stages.size() - 1, 0);
+
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+#endif /* PIPELINE_HPP */
+
@@ -220,14 +220,12 @@ Point2i Roi::findClosestValid(const Point2d& center, const Mat& depth, const Rec
     
     bool skipRow = false;
     bool skipCol = false;
-    const float* zRow = NULL;
     float distance;
     float minDistance = roi.width > roi.height ? roi.width : roi.height;
     int minRow = -1;
     int minCol = -1;
     
     for(int r = startPoint.y; r <= stopPoint.y; r++){
-        zRow = depth.ptr<float>(r);
         if(iteration != 0 && r > startPoint.y && r < stopPoint.y){
             skipRow = true;
         }else{
@@ -244,7 +242,7 @@ Point2i Roi::findClosestValid(const Point2d& center, const Mat& depth, const Rec
             if(skipCol && skipRow){
                 continue;
             } else{
-                if(zRow[c] > 1e-7){
+                if(getDepth(depth, r, c) > 1e-7){
                     distance = Roi::calculateDistance(center, Point2d(c, r));
                     
                     if(distance < minDistance){
@@ -270,6 +268,13 @@ float Roi::calculateDistance(const Point2d& center, const Point2d& pixel){
     return sqrt(xx + yy);
 }
 
+float Roi::getDepth(const Mat& depth, int row, int col) {
+    if (depth.type() == CV_16UC1) {
+        return depth.at<unsigned short>(row, col);
+    }
+    return depth.at<float>(row, col);
+}
+
 Point2d Roi::getLocalCenter(const Rect2d& roi){
     return Point2d(roi.x + roi.width/2.0, roi.y + roi.height/2.0);
 }
@@ -298,7 +303,7 @@ Point3d Roi::getMetricCenter(const Rect2d& roi, const Mat& depth, const Mat& hom
         throw gk::Exception(__FILE__, __LINE__, message);*/
         validPixel = Point2i(0,0);
     }
-    Point3d localPoint(validPixel.x, validPixel.y, depth.at<float>(validPixel.y, validPixel.x));
+    Point3d localPoint(validPixel.x, validPixel.y, getDepth(depth, validPixel.y, validPixel.x));
             
     return Roi::getXYZWorld(localPoint, homography);
 }
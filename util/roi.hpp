@@ -61,6 +61,10 @@ namespace gk {
 
         static float calculateDistance(const Point2d& center, const Point2d& pixel);
 
+        // Depth in millimeters from float image or uint16 frame of depth 
+        // container
+        static float getDepth(const Mat& depth, int row, int col);
+
         static Point2d getLocalCenter(const Rect2d& roi);
 
         static Point3d getXYZWorld(const Point3d& localPoint, const Mat& homography);
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "threadpool.hpp"
+
+using namespace gk;
+
+ThreadPool::ThreadPool(int threadCount, const ThreadInit& threadInit)
+: taskCount(0), nextTask(0), doneCount(0), generation(0), stopping(false) {
+    for (int i = 0; i < threadCount; i++) {
+        threads.push_back(std::thread(&ThreadPool::work, this, i, threadInit));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    hasTasks.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::work(int index, ThreadInit threadInit) {
+    if (threadInit) {
+        threadInit(index);
+    }
+    
+    long seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        hasTasks.wait(lock, [&] {
+            return stopping || generation != seenGeneration;
+        });
+        if (stopping) {
+            return;
+        }
+        seenGeneration = generation;
+        runTasks(lock);
+    }
+}
+
+void ThreadPool::runTasks(std::unique_lock<std::mutex>& lock) {
+    while (nextTask < taskCount) {
+        size_t index = nextTask++;
+        
+        lock.unlock();
+        std::exception_ptr taskError;
+        try {
+            task(index);
+        } catch (...) {
+            taskError = std::current_exception();
+        }
+        lock.lock();
+        
+        if (taskError && !error) {
+            error = taskError;
+        }
+        if (++doneCount == taskCount) {
+            tasksDone.notify_all();
+        }
+    }
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    this->task = task;
+    taskCount = count;
+    nextTask = 0;
+    doneCount = 0;
+    error = nullptr;
+    generation++;
+    hasTasks.notify_all();
+    
+    runTasks(lock);
+    tasksDone.wait(lock, [this] {
+        return doneCount == taskCount;
+    });
+    
+    std::exception_ptr taskError = error;
+    error = nullptr;
+    lock.unlock();
+    if (taskError) {
+        std::rethrow_exception(taskError);
+    }
+}
+
+int ThreadPool::getThreadCount() const {
+    return (int) threads.size();
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2017 Gregor Koporec <gregor.koporec@gmail.com>, University of Ljubljana
+ * Copyright (C) 2017 Janez Pers <janez.pers@fe.uni-lj.si>, University of Ljubljana
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+using namespace std;
+
+namespace gk {
+
+    /**
+     * Fixed pool of threads for fork-join work, e.g. updating every 
+     * camera before camera selection. Calling thread works too, so pool
+     * with N threads runs N + 1 tasks at once.
+     */
+    class ThreadPool {
+    public:
+        // Called on every pool thread before it takes tasks, with index
+        // of thread from 0
+        typedef std::function<void(int)> ThreadInit;
+
+    private:
+        vector<std::thread> threads;
+
+        // Guarded by mutex
+        std::function<void(size_t)> task;
+        size_t taskCount;
+        size_t nextTask;
+        size_t doneCount;
+        long generation;
+        bool stopping;
+        std::exception_ptr error;
+
+        std::mutex mutex;
+        std::condition_variable hasTasks;
+        std::condition_variable tasksDone;
+
+        void work(int index, ThreadInit threadInit);
+        void runTasks(std::unique_lock<std::mutex>& lock);
+
+    public:
+        /**
+         * @param threadCount Threads besides calling thread, can be 0.
+         */
+        ThreadPool(int threadCount, const ThreadInit& threadInit = nullptr);
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * Calls task(i) for every i in [0, count) and returns when all 
+         * calls finished (barrier). First exception of tasks is rethrown.
+         * Must not be called from more threads at once.
+         */
+        void run(size_t count, const std::function<void(size_t)>& task);
+
+        int getThreadCount() const;
+    };
+}
+
+#endif /* THREADPOOL_HPP */
+